@@ -0,0 +1,177 @@
+#pragma once
+
+#include <sched.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Noisy neighbor pinned to the SMT sibling of the calling thread's core.
+class Antagonist
+{
+public:
+    enum Kind
+    {
+        MemoryStreamer, // streams a buffer far larger than LLC, competing for DRAM bandwidth and fill buffers
+        CacheThrasher,  // random lines over an L2-sized buffer, evicting the shared L1/L2
+        PopcntHog,      // independent popcnt chains, saturating the port the kernels use
+        KindCount
+    };
+
+    static const char* Name (int kind) noexcept
+    {
+        constexpr const char* names[] = {"memory_streamer", "cache_thrasher", "popcnt_hog"};
+        return kind >= 0 && kind < KindCount ? names[kind] : "unknown";
+    }
+
+    // Pins the calling thread to its current cpu; Available() is false when the core has no sibling
+    Antagonist()
+    {
+        const int cpu = sched_getcpu();
+        m_sibling = cpu < 0 ? -1 : FindSibling (cpu);
+        if (m_sibling < 0)
+            return;
+
+        pthread_getaffinity_np (pthread_self(), sizeof (m_saved), &m_saved);
+        Pin (pthread_self(), cpu);
+    }
+
+    // Returns once the antagonist has set up its buffers and is about to start interfering
+    void Start (int kind)
+    {
+        m_thread = std::thread ([this, kind]()
+            {
+                Pin (pthread_self(), m_sibling);
+                switch (kind)
+                {
+                case MemoryStreamer: StreamMemory(); break;
+                case CacheThrasher: ThrashCache(); break;
+                default: HogPopcnt(); break;
+                }
+            });
+
+        while (!m_ready.load (std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    Antagonist (const Antagonist&) = delete;
+    Antagonist& operator= (const Antagonist&) = delete;
+
+    ~Antagonist()
+    {
+        if (m_thread.joinable())
+        {
+            m_stop.store (true, std::memory_order_relaxed);
+            m_thread.join();
+        }
+
+        if (Available())
+            pthread_setaffinity_np (pthread_self(), sizeof (m_saved), &m_saved);
+    }
+
+    bool Available() const noexcept
+    {
+        return m_sibling >= 0;
+    }
+
+    int Sibling() const noexcept
+    {
+        return m_sibling;
+    }
+
+private:
+    static int FindSibling (int cpu)
+    {
+        std::ifstream in ("/sys/devices/system/cpu/cpu" + std::to_string (cpu) + "/topology/thread_siblings_list");
+        std::string list;
+        if (!std::getline (in, list))
+            return -1;
+
+        // Format is either "0,64" or "0-1"
+        std::istringstream ranges (list);
+        for (std::string range; std::getline (ranges, range, ',');)
+        {
+            const auto dash = range.find ('-');
+            const int first = std::stoi (range.substr (0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi (range.substr (dash + 1));
+            for (int ii = first; ii <= last; ++ii)
+                if (ii != cpu)
+                    return ii;
+        }
+
+        return -1;
+    }
+
+    static void Pin (pthread_t thread, int cpu)
+    {
+        cpu_set_t set;
+        CPU_ZERO (&set);
+        CPU_SET (cpu, &set);
+        pthread_setaffinity_np (thread, sizeof (set), &set);
+    }
+
+    void Ready() noexcept
+    {
+        m_ready.store (true, std::memory_order_release);
+    }
+
+    void StreamMemory()
+    {
+        // Filled, hence faulted in, before Ready(); m_stop is polled after every chunk
+        constexpr size_t chunk = (4ull << 20) / sizeof (uint64_t);
+        std::vector<uint64_t> buffer (64 * chunk, 1);
+        Ready();
+
+        uint64_t sum = 0;
+        for (size_t offset = 0; !m_stop.load (std::memory_order_relaxed); offset = (offset + chunk) % buffer.size())
+            for (size_t ii = offset; ii < offset + chunk; ++ii)
+                sum += buffer[ii]++;
+        m_sink = sum;
+    }
+
+    void ThrashCache()
+    {
+        constexpr size_t lines = (2ull << 20) / 64;
+        std::vector<uint64_t> buffer (lines * 8, 1);
+        Ready();
+
+        uint64_t sum = 0;
+        uint32_t idx = 1;
+        while (!m_stop.load (std::memory_order_relaxed))
+            for (size_t ii = 0; ii < lines; ++ii)
+            {
+                idx = idx * 1664525u + 1013904223u;
+                sum += buffer[(idx % lines) * 8]++;
+            }
+        m_sink = sum;
+    }
+
+    __attribute__((target("popcnt")))
+    void HogPopcnt()
+    {
+        uint64_t a = 0x0123456789abcdef, b = ~a, c = a << 1, d = b >> 1;
+        Ready();
+        while (!m_stop.load (std::memory_order_relaxed))
+            for (size_t ii = 0; ii < 4096; ++ii)
+            {
+                a += __builtin_popcountll (a);
+                b += __builtin_popcountll (b);
+                c += __builtin_popcountll (c);
+                d += __builtin_popcountll (d);
+                asm volatile ("" : "+r" (a), "+r" (b), "+r" (c), "+r" (d));
+            }
+        m_sink = a + b + c + d;
+    }
+
+    std::atomic<bool> m_stop {false};
+    std::atomic<bool> m_ready {false};
+    int m_sibling = -1;
+    cpu_set_t m_saved;
+    std::thread m_thread;
+    volatile uint64_t m_sink = 0;
+};
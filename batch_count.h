@@ -0,0 +1,217 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "best_count.h"
+#include "count_bits.h"
+
+// Popcounts of many small bitmaps of equal size, one count each. Per bitmap a bulk call pays
+// its setup and a horizontal sum, which for 64-512 byte bitmaps is much of the work. The
+// transposed kernel instead keeps one vector accumulator per bitmap for 16 bitmaps and
+// reduces the 16 of them to one vector of 16 counts with 15 adds.
+
+namespace batch_count
+{
+
+// Where the bitmaps are: Row (ii) is the first of `words` words of bitmap ii
+
+// Back to back
+struct Contiguous
+{
+    const uint32_t* data;
+    size_t words;
+
+    const uint32_t* Row (size_t ii) const noexcept
+    {
+        return data + ii * words;
+    }
+};
+
+// Every `stride` bytes, a multiple of 4, e.g. one column group of a row-major table
+struct Strided
+{
+    const void* data;
+    size_t words;
+    size_t stride;
+
+    const uint32_t* Row (size_t ii) const noexcept
+    {
+        return reinterpret_cast<const uint32_t*> (static_cast<const char*> (data) + ii * stride);
+    }
+};
+
+struct Pointers
+{
+    const uint32_t* const* rows;
+    size_t words;
+
+    const uint32_t* Row (size_t ii) const noexcept
+    {
+        return rows[ii];
+    }
+};
+
+// The baseline: one CountBulk call per bitmap
+template <class Solution>
+struct PerRowKernel
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    template <class Rows>
+    static void Count (const Rows& rows, size_t size, uint32_t* counts) noexcept
+    {
+        for (size_t ii = 0; ii < size; ++ii)
+            counts[ii] = static_cast<uint32_t> (CountBulk<Solution> (rows.Row (ii), rows.words));
+    }
+};
+
+// Calls body with the bitmap size as a compile time count of whole cache lines, up to the
+// 512 bytes of the sizes this is for, or with 0 for any other size
+template <class Body>
+void DispatchLines (size_t words, const Body& body)
+{
+    switch (words)
+    {
+    case 16: body (std::integral_constant<size_t, 1> {}); break;
+    case 32: body (std::integral_constant<size_t, 2> {}); break;
+    case 48: body (std::integral_constant<size_t, 3> {}); break;
+    case 64: body (std::integral_constant<size_t, 4> {}); break;
+    case 80: body (std::integral_constant<size_t, 5> {}); break;
+    case 96: body (std::integral_constant<size_t, 6> {}); break;
+    case 112: body (std::integral_constant<size_t, 7> {}); break;
+    case 128: body (std::integral_constant<size_t, 8> {}); break;
+    default: body (std::integral_constant<size_t, 0> {}); break;
+    }
+}
+
+// vpopcntd over one bitmap of Lines cache lines, or of `words` words with the tail under a
+// mask when Lines is 0
+template <size_t Lines>
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline __m512i RowPopcounts (const uint32_t* row, size_t words, __mmask16 tail) noexcept
+{
+    auto acc = _mm512_setzero_si512();
+    if constexpr (Lines != 0)
+    {
+        for (size_t ll = 0; ll < Lines; ++ll)
+            acc = _mm512_add_epi32 (acc, _mm512_popcnt_epi32 (_mm512_loadu_si512 (row + ll * 16)));
+    }
+    else
+    {
+        size_t ww = 0;
+        for (; ww + 16 <= words; ww += 16)
+            acc = _mm512_add_epi32 (acc, _mm512_popcnt_epi32 (_mm512_loadu_si512 (row + ww)));
+        if (tail)
+            acc = _mm512_add_epi32 (acc, _mm512_popcnt_epi32 (_mm512_maskz_loadu_epi32 (tail, row + ww)));
+    }
+    return acc;
+}
+
+// One horizontal sum per bitmap, for comparison
+struct Avx512RowKernel
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512vpopcntdq");
+    }
+
+    template <class Rows>
+    static void Count (const Rows& rows, size_t size, uint32_t* counts) noexcept
+    {
+        DispatchLines (rows.words, [&](auto lines) { CountLines<decltype (lines)::value> (rows, size, counts); });
+    }
+
+private:
+    template <size_t Lines, class Rows>
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static void CountLines (const Rows& rows, size_t size, uint32_t* counts) noexcept
+    {
+        const auto words = rows.words;
+        const auto tail = static_cast<__mmask16> ((1u << (words % 16)) - 1);
+        for (size_t ii = 0; ii < size; ++ii)
+            counts[ii] = _mm512_reduce_add_epi32 (RowPopcounts<Lines> (rows.Row (ii), words, tail));
+    }
+};
+
+struct Avx512TransposedKernel
+{
+    static bool Available() noexcept
+    {
+        return Avx512RowKernel::Available();
+    }
+
+    template <class Rows>
+    static void Count (const Rows& rows, size_t size, uint32_t* counts) noexcept
+    {
+        DispatchLines (rows.words, [&](auto lines) { CountLines<decltype (lines)::value> (rows, size, counts); });
+    }
+
+private:
+    template <size_t Lines, class Rows>
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static void CountLines (const Rows& rows, size_t size, uint32_t* counts) noexcept
+    {
+        const auto words = rows.words;
+        const auto tail = static_cast<__mmask16> ((1u << (words % 16)) - 1);
+        __m512i acc[16];
+        size_t ii = 0;
+        for (; ii + 16 <= size; ii += 16)
+        {
+            for (size_t rr = 0; rr < 16; ++rr)
+                acc[rr] = RowPopcounts<Lines> (rows.Row (ii + rr), words, tail);
+            _mm512_storeu_si512 (counts + ii, Reduce (acc));
+        }
+
+        if (ii < size)
+        {
+            for (size_t rr = 0; rr < 16; ++rr)
+                acc[rr] = ii + rr < size ? RowPopcounts<Lines> (rows.Row (ii + rr), words, tail) : _mm512_setzero_si512();
+            _mm512_mask_storeu_epi32 (counts + ii, static_cast<__mmask16> ((1u << (size - ii)) - 1), Reduce (acc));
+        }
+    }
+
+    // Lane rr of the result is the sum of the lanes of acc[rr]. Each level halves the vectors
+    // and doubles the bitmaps per vector: dword then qword interleaves inside 128-bit lanes
+    // leave per-quarter sums of 4 bitmaps, two 128-bit lane shuffles fold the quarters.
+    __attribute__((target("avx512f")))
+    static __m512i Reduce (const __m512i* acc) noexcept
+    {
+        __m512i pairs[8];
+        for (size_t rr = 0; rr < 8; ++rr)
+            pairs[rr] = _mm512_add_epi32 (_mm512_unpacklo_epi32 (acc[2 * rr], acc[2 * rr + 1]),
+                _mm512_unpackhi_epi32 (acc[2 * rr], acc[2 * rr + 1]));
+
+        __m512i quads[4];
+        for (size_t rr = 0; rr < 4; ++rr)
+            quads[rr] = _mm512_add_epi32 (_mm512_unpacklo_epi64 (pairs[2 * rr], pairs[2 * rr + 1]),
+                _mm512_unpackhi_epi64 (pairs[2 * rr], pairs[2 * rr + 1]));
+
+        __m512i halves[2];
+        for (size_t rr = 0; rr < 2; ++rr)
+            halves[rr] = _mm512_add_epi32 (_mm512_shuffle_i32x4 (quads[2 * rr], quads[2 * rr + 1], _MM_SHUFFLE (2, 0, 2, 0)),
+                _mm512_shuffle_i32x4 (quads[2 * rr], quads[2 * rr + 1], _MM_SHUFFLE (3, 1, 3, 1)));
+
+        return _mm512_add_epi32 (_mm512_shuffle_i32x4 (halves[0], halves[1], _MM_SHUFFLE (2, 0, 2, 0)),
+            _mm512_shuffle_i32x4 (halves[0], halves[1], _MM_SHUFFLE (3, 1, 3, 1)));
+    }
+};
+
+// Transposed AVX-512 where the cpu has it, one BestCount bulk call per bitmap elsewhere
+template <class Rows>
+void Count (const Rows& rows, size_t size, uint32_t* counts) noexcept
+{
+    static const bool hasAvx512 = Avx512TransposedKernel::Available();
+    if (hasAvx512)
+        Avx512TransposedKernel::Count (rows, size, counts);
+    else
+        PerRowKernel<BestCount>::Count (rows, size, counts);
+}
+
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "batch_count.h"
+
+using batch_count::Avx512RowKernel;
+using batch_count::Avx512TransposedKernel;
+using batch_count::Contiguous;
+using batch_count::PerRowKernel;
+using batch_count::Pointers;
+using batch_count::Strided;
+
+namespace
+{
+
+// Strided bitmaps are followed by a cache line of other columns
+constexpr size_t g_gapWords = 16;
+
+// Bitmaps and whatever is needed to reach them in the given layout
+template <class Rows>
+struct Batch
+{
+    Batch (size_t size, size_t words, uint32_t seed)
+        : storage (size * (words + (std::is_same<Rows, Strided>::value ? g_gapWords : 0)))
+    {
+        std::mt19937 gen(seed);
+        for (auto& word : storage)
+            word = gen();
+
+        if constexpr (std::is_same<Rows, Contiguous>::value)
+            rows = {storage.data(), words};
+        else if constexpr (std::is_same<Rows, Strided>::value)
+            rows = {storage.data(), words, (words + g_gapWords) * sizeof (uint32_t)};
+        else
+        {
+            // Rows of a hash table or a heap: the same bitmaps visited in random order
+            for (size_t ii = 0; ii < size; ++ii)
+                pointers.push_back (storage.data() + ii * words);
+            std::shuffle (pointers.begin(), pointers.end(), gen);
+            rows = {pointers.data(), words};
+        }
+    }
+
+    std::vector<uint32_t> storage;
+    std::vector<const uint32_t*> pointers;
+    Rows rows;
+};
+
+}
+
+// Args: bytes per bitmap, bitmaps. One item is one bitmap counted.
+template <class Kernel, class Rows>
+void BM_BatchCount (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const size_t bitmaps = state.range (1);
+    const Batch<Rows> batch (bitmaps, state.range (0) / sizeof (uint32_t), 1);
+    std::vector<uint32_t> counts (bitmaps);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        Kernel::Count (batch.rows, bitmaps, counts.data());
+        benchmark::DoNotOptimize (counts.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * bitmaps);
+    state.SetBytesProcessed (state.iterations() * bitmaps * state.range (0));
+}
+
+// Bitmaps fitting in L2 and bitmaps streamed from memory
+static void BatchArgs (benchmark::internal::Benchmark* b)
+{
+    b->ArgNames ({"bytes", "bitmaps"});
+    for (int64_t bitmaps : {1 << 10, 1 << 16})
+        for (int64_t bytes : {64, 128, 256, 512})
+            b->Args ({bytes, bitmaps});
+}
+
+#define BATCH_COUNT(Kernel) \
+    BENCHMARK_TEMPLATE(BM_BatchCount, Kernel, Contiguous)->Apply (BatchArgs); \
+    BENCHMARK_TEMPLATE(BM_BatchCount, Kernel, Strided)->Apply (BatchArgs); \
+    BENCHMARK_TEMPLATE(BM_BatchCount, Kernel, Pointers)->Apply (BatchArgs);
+
+BATCH_COUNT(PerRowKernel<AsmSolution>)
+BATCH_COUNT(PerRowKernel<Avx2Solution>)
+BATCH_COUNT(PerRowKernel<BestCount>)
+BATCH_COUNT(Avx512RowKernel)
+BATCH_COUNT(Avx512TransposedKernel)
+
+#undef BATCH_COUNT
+
+// Every kernel and layout against ReferenceSolution, on sizes leaving masked word tails and
+// partial groups of 16 bitmaps
+void BM_BatchCountCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t words : {1, 15, 16, 17, 48, 100, 128})
+            for (size_t size : {1, 15, 16, 17, 100})
+            {
+                const auto check = [&](auto layout)
+                    {
+                        using Rows = decltype (layout);
+                        const Batch<Rows> batch (size, words, static_cast<uint32_t> (words * size));
+
+                        std::vector<uint32_t> etalon (size);
+                        PerRowKernel<ReferenceSolution>::Count (batch.rows, size, etalon.data());
+
+                        const auto compare = [&](auto kernel)
+                            {
+                                using Kernel = decltype (kernel);
+                                if (!Kernel::Available())
+                                    return;
+                                // One past the end must stay untouched by the masked stores
+                                std::vector<uint32_t> counts (size + 1, 12345);
+                                Kernel::Count (batch.rows, size, counts.data());
+                                if (!std::equal (etalon.begin(), etalon.end(), counts.begin()) || counts.back() != 12345)
+                                    throw std::runtime_error ("test");
+                            };
+
+                        compare (PerRowKernel<AsmSolution> {});
+                        compare (PerRowKernel<BestCount> {});
+                        compare (Avx512RowKernel {});
+                        compare (Avx512TransposedKernel {});
+
+                        std::vector<uint32_t> counts (size);
+                        batch_count::Count (batch.rows, size, counts.data());
+                        if (counts != etalon)
+                            throw std::runtime_error ("test");
+                    };
+
+                check (Contiguous {});
+                check (Strided {});
+                check (Pointers {});
+            }
+    }
+}
+
+BENCHMARK (BM_BatchCountCheck);
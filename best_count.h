@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include "count_bits.h"
+#include "count_bits_avx2.h"
+
+// Kernels count_bits_autotune chooses from. FullTableSolution is left out: its 16 GiB table
+// does not fit most hosts the tuner runs on.
+#define BEST_COUNT_CANDIDATES(X) \
+    X(ReferenceSolution) \
+    X(AsmSolution) \
+    X(MagicSolution) \
+    X(ByteTableSolution) \
+    X(ElevenBitsTableSolution) \
+    X(WordsTableSolution) \
+    X(Avx2Solution)
+
+constexpr const char* g_bestCountCandidateNames[] =
+{
+#define NAME(Solution) #Solution,
+    BEST_COUNT_CANDIDATES(NAME)
+#undef NAME
+};
+
+// Upper bound in elements of every size class but the last, which is open-ended
+constexpr size_t g_bestCountSizeClasses[] = {64, 1024, 16384, 262144};
+
+// Defines BestCountKernels, one kernel per size class, and whether the autotune target chose them
+#include "best_count_config.h"
+
+// Bulk popcount dispatching to the kernel the host was tuned to prefer for the input size
+struct BestCount
+{
+    static constexpr size_t SizeClass (size_t size) noexcept
+    {
+        size_t res = 0;
+        while (res + 1 < std::size (g_bestCountSizeClasses) && size > g_bestCountSizeClasses[res])
+            ++res;
+        return res;
+    }
+
+    static uint64_t CountBulk (const uint32_t* data, size_t size) noexcept
+    {
+        return Dispatch (data, size, std::make_index_sequence<std::size (g_bestCountSizeClasses)>());
+    }
+
+private:
+    static_assert (std::tuple_size_v<BestCountKernels> == std::size (g_bestCountSizeClasses),
+        "best_count_config.h is stale, rerun the autotune target");
+
+    template <size_t... Classes>
+    static uint64_t Dispatch (const uint32_t* data, size_t size, std::index_sequence<Classes...>) noexcept
+    {
+        const auto sizeClass = SizeClass (size);
+        uint64_t res = 0;
+        boost::ignore_unused (((sizeClass == Classes &&
+            (res = ::CountBulk<std::tuple_element_t<Classes, BestCountKernels>> (data, size), true)) || ...));
+        return res;
+    }
+};
+
+template <>
+inline uint64_t CountBulk<BestCount> (const uint32_t* data, size_t size) noexcept
+{
+    return BestCount::CountBulk (data, size);
+}
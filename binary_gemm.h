@@ -0,0 +1,246 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "count_bits.h"
+#include "parallel_for.h"
+
+// Binary GEMM for binarized networks: bit 1 stands for +1, bit 0 for -1, and the dot product
+// of two K-bit rows is K - 2 * popcount(a ^ w), the popcount(xnor) form with the padding
+// bits, zero in both operands, cancelling out. C = A * W^T with W stored one output per row.
+
+namespace binary_gemm
+{
+
+// Rows padded to whole cache lines, so the vector kernels never see a tail
+constexpr size_t g_rowAlign = 8;
+
+struct BitMatrix
+{
+    BitMatrix (size_t rows, size_t bits)
+        : rows (rows),
+          bits (bits),
+          stride ((bits + 64 * g_rowAlign - 1) / (64 * g_rowAlign) * g_rowAlign),
+          data (rows * stride)
+    {
+    }
+
+    bool Get (size_t row, size_t bit) const noexcept
+    {
+        return (data[row * stride + bit / 64] >> (bit % 64)) & 1;
+    }
+
+    void Set (size_t row, size_t bit) noexcept
+    {
+        data[row * stride + bit / 64] |= uint64_t (1) << (bit % 64);
+    }
+
+    const uint64_t* Row (size_t row) const noexcept
+    {
+        return data.data() + row * stride;
+    }
+
+    size_t rows;
+    size_t bits;
+    size_t stride; // words per row
+    std::vector<uint64_t> data;
+};
+
+// Micro-kernels add popcount(a_i ^ w_j) over `words` words for an Mr x Nr tile of C
+
+template <class Solution>
+struct ScalarKernel
+{
+    static constexpr size_t g_mr = 2;
+    static constexpr size_t g_nr = 4;
+
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    template <size_t Mr, size_t Nr>
+    static void Tile (const uint64_t* a, size_t lda, const uint64_t* w, size_t ldw, size_t words, int32_t* c, size_t ldc) noexcept
+    {
+        uint32_t acc[Mr][Nr] = {};
+        for (size_t kk = 0; kk < words; ++kk)
+            for (size_t ii = 0; ii < Mr; ++ii)
+                for (size_t jj = 0; jj < Nr; ++jj)
+                {
+                    const auto x = a[ii * lda + kk] ^ w[jj * ldw + kk];
+                    acc[ii][jj] += Solution::Count (static_cast<uint32_t> (x)) + Solution::Count (static_cast<uint32_t> (x >> 32));
+                }
+
+        for (size_t ii = 0; ii < Mr; ++ii)
+            for (size_t jj = 0; jj < Nr; ++jj)
+                c[ii * ldc + jj] += acc[ii][jj];
+    }
+};
+
+// vpshufb nibble lookup as in CountBulkAvx2, byte counters folded by vpsadbw
+struct Avx2Kernel
+{
+    static constexpr size_t g_mr = 2;
+    static constexpr size_t g_nr = 2;
+
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx2");
+    }
+
+    template <size_t Mr, size_t Nr>
+    __attribute__((target("avx2")))
+    static void Tile (const uint64_t* a, size_t lda, const uint64_t* w, size_t ldw, size_t words, int32_t* c, size_t ldc) noexcept
+    {
+        const auto lookup = _mm256_setr_epi8 (0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                              0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const auto nibble = _mm256_set1_epi8 (0x0F);
+        const auto zero = _mm256_setzero_si256();
+
+        __m256i total[Mr][Nr];
+        for (size_t ii = 0; ii < Mr; ++ii)
+            for (size_t jj = 0; jj < Nr; ++jj)
+                total[ii][jj] = zero;
+
+        size_t kk = 0;
+        while (kk < words)
+        {
+            // A byte lane gains at most 8 per step, so fold into 64-bit lanes before it wraps
+            __m256i bytes[Mr][Nr];
+            for (size_t ii = 0; ii < Mr; ++ii)
+                for (size_t jj = 0; jj < Nr; ++jj)
+                    bytes[ii][jj] = zero;
+
+            for (size_t step = 0; step < 31 && kk < words; ++step, kk += 4)
+            {
+                __m256i wv[Nr];
+                for (size_t jj = 0; jj < Nr; ++jj)
+                    wv[jj] = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (w + jj * ldw + kk));
+
+                for (size_t ii = 0; ii < Mr; ++ii)
+                {
+                    const auto av = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (a + ii * lda + kk));
+                    for (size_t jj = 0; jj < Nr; ++jj)
+                    {
+                        const auto v = _mm256_xor_si256 (av, wv[jj]);
+                        const auto lo = _mm256_shuffle_epi8 (lookup, _mm256_and_si256 (v, nibble));
+                        const auto hi = _mm256_shuffle_epi8 (lookup, _mm256_and_si256 (_mm256_srli_epi16 (v, 4), nibble));
+                        bytes[ii][jj] = _mm256_add_epi8 (bytes[ii][jj], _mm256_add_epi8 (lo, hi));
+                    }
+                }
+            }
+
+            for (size_t ii = 0; ii < Mr; ++ii)
+                for (size_t jj = 0; jj < Nr; ++jj)
+                    total[ii][jj] = _mm256_add_epi64 (total[ii][jj], _mm256_sad_epu8 (bytes[ii][jj], zero));
+        }
+
+        for (size_t ii = 0; ii < Mr; ++ii)
+            for (size_t jj = 0; jj < Nr; ++jj)
+            {
+                const auto t = total[ii][jj];
+                c[ii * ldc + jj] += _mm256_extract_epi64 (t, 0) + _mm256_extract_epi64 (t, 1) +
+                    _mm256_extract_epi64 (t, 2) + _mm256_extract_epi64 (t, 3);
+            }
+    }
+};
+
+// vpopcntq on whole cache lines
+struct Avx512Kernel
+{
+    static constexpr size_t g_mr = 2;
+    static constexpr size_t g_nr = 4;
+
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512vpopcntdq");
+    }
+
+    template <size_t Mr, size_t Nr>
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static void Tile (const uint64_t* a, size_t lda, const uint64_t* w, size_t ldw, size_t words, int32_t* c, size_t ldc) noexcept
+    {
+        __m512i acc[Mr][Nr];
+        for (size_t ii = 0; ii < Mr; ++ii)
+            for (size_t jj = 0; jj < Nr; ++jj)
+                acc[ii][jj] = _mm512_setzero_si512();
+
+        for (size_t kk = 0; kk < words; kk += 8)
+        {
+            __m512i wv[Nr];
+            for (size_t jj = 0; jj < Nr; ++jj)
+                wv[jj] = _mm512_loadu_si512 (w + jj * ldw + kk);
+
+            for (size_t ii = 0; ii < Mr; ++ii)
+            {
+                const auto av = _mm512_loadu_si512 (a + ii * lda + kk);
+                for (size_t jj = 0; jj < Nr; ++jj)
+                    acc[ii][jj] = _mm512_add_epi64 (acc[ii][jj], _mm512_popcnt_epi64 (_mm512_xor_si512 (av, wv[jj])));
+            }
+        }
+
+        for (size_t ii = 0; ii < Mr; ++ii)
+            for (size_t jj = 0; jj < Nr; ++jj)
+                c[ii * ldc + jj] += _mm512_reduce_add_epi64 (acc[ii][jj]);
+    }
+};
+
+// Panel sizes: g_nc rows of W by g_kc words stay in L2 while every Mr-row strip of A
+// streams past them, an A strip of g_kc words stays in L1 across the panel
+constexpr size_t g_kc = 256;
+constexpr size_t g_nc = 64;
+
+template <class Kernel>
+void GemmRows (const BitMatrix& a, const BitMatrix& w, int32_t* c, size_t first, size_t last) noexcept
+{
+    constexpr size_t mr = Kernel::g_mr;
+    constexpr size_t nr = Kernel::g_nr;
+    const size_t n = w.rows;
+
+    std::fill (c + first * n, c + last * n, 0);
+
+    for (size_t jc = 0; jc < n; jc += g_nc)
+    {
+        const auto jEnd = std::min (jc + g_nc, n);
+        for (size_t pc = 0; pc < a.stride; pc += g_kc)
+        {
+            const auto kc = std::min (g_kc, a.stride - pc);
+            for (size_t ii = first; ii < last; ii += mr)
+            {
+                const auto* ap = a.Row (ii) + pc;
+                auto* cp = c + ii * n;
+                size_t jj = jc;
+                if (ii + mr <= last)
+                    for (; jj + nr <= jEnd; jj += nr)
+                        Kernel::template Tile<mr, nr> (ap, a.stride, w.Row (jj) + pc, w.stride, kc, cp + jj, n);
+
+                // Edges one element at a time
+                for (size_t i2 = ii; i2 < std::min (ii + mr, last); ++i2)
+                    for (size_t j2 = jj; j2 < jEnd; ++j2)
+                        Kernel::template Tile<1, 1> (a.Row (i2) + pc, a.stride, w.Row (j2) + pc, w.stride, kc, c + i2 * n + j2, n);
+            }
+        }
+    }
+
+    const auto bits = static_cast<int32_t> (a.bits);
+    for (auto* p = c + first * n; p != c + last * n; ++p)
+        *p = bits - 2 * *p;
+}
+
+// c is a.rows x w.rows, row-major. Rows of C are split over `threads` threads in whole Mr strips.
+template <class Kernel>
+void Gemm (const BitMatrix& a, const BitMatrix& w, int32_t* c, size_t threads = 1)
+{
+    constexpr size_t mr = Kernel::g_mr;
+    ParallelFor ((a.rows + mr - 1) / mr, threads, [&a, &w, c](size_t, size_t first, size_t last)
+        {
+            GemmRows<Kernel> (a, w, c, std::min (first * mr, a.rows), std::min (last * mr, a.rows));
+        });
+}
+
+}
@@ -0,0 +1,105 @@
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "binary_gemm.h"
+#include "random_bit_matrix.h"
+
+using binary_gemm::Avx2Kernel;
+using binary_gemm::Avx512Kernel;
+using binary_gemm::BitMatrix;
+using binary_gemm::ScalarKernel;
+
+// Args: M, N, K bits, threads. One op is one xnor or one accumulate per bit, the usual BNN count.
+template <class Kernel>
+void BM_BinaryGemm (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const auto a = RandomMatrix (state.range (0), state.range (2), 1);
+    const auto w = RandomMatrix (state.range (1), state.range (2), 2);
+    std::vector<int32_t> c (a.rows * w.rows);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        binary_gemm::Gemm<Kernel> (a, w, c.data(), state.range (3));
+        benchmark::DoNotOptimize (c.data());
+        benchmark::ClobberMemory();
+    }
+
+    const auto ops = 2.0 * a.rows * w.rows * a.bits;
+    state.counters["ops"] = benchmark::Counter (ops, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void GemmShapes (benchmark::internal::Benchmark* b)
+{
+    const int64_t shapes[][3] =
+        {
+            {1, 1024, 4096},    // single-sample fully connected layer
+            {64, 256, 1152},    // 3x3x128 convolution as GEMM
+            {256, 256, 4096},
+            {1024, 1024, 4096}
+        };
+
+    b->ArgNames ({"M", "N", "K", "threads"});
+    for (const auto& shape : shapes)
+        for (int64_t threads : {1, 4})
+            b->Args ({shape[0], shape[1], shape[2], threads});
+    b->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_BinaryGemm, ScalarKernel<AsmSolution>)->Apply (GemmShapes);
+BENCHMARK_TEMPLATE(BM_BinaryGemm, ScalarKernel<MagicSolution>)->Apply (GemmShapes);
+BENCHMARK_TEMPLATE(BM_BinaryGemm, Avx2Kernel)->Apply (GemmShapes);
+BENCHMARK_TEMPLATE(BM_BinaryGemm, Avx512Kernel)->Apply (GemmShapes);
+
+// Every kernel against a bit-by-bit +-1 dot product, on shapes leaving edge tiles and panels
+void BM_BinaryGemmCheck (benchmark::State &state)
+{
+    const size_t shapes[][3] = {{1, 1, 1}, {3, 5, 63}, {7, 9, 130}, {5, 67, 20000}, {33, 2, 513}};
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (const auto& shape : shapes)
+        {
+            const auto a = RandomMatrix (shape[0], shape[2], 3);
+            const auto w = RandomMatrix (shape[1], shape[2], 4);
+
+            std::vector<int32_t> etalon (a.rows * w.rows);
+            for (size_t ii = 0; ii < a.rows; ++ii)
+                for (size_t jj = 0; jj < w.rows; ++jj)
+                    for (size_t bit = 0; bit < a.bits; ++bit)
+                        etalon[ii * w.rows + jj] += a.Get (ii, bit) == w.Get (jj, bit) ? 1 : -1;
+
+            const auto check = [&](auto kernel, size_t threads)
+                {
+                    using Kernel = decltype (kernel);
+                    if (!Kernel::Available())
+                        return;
+                    std::vector<int32_t> c (a.rows * w.rows, 12345);
+                    binary_gemm::Gemm<Kernel> (a, w, c.data(), threads);
+                    if (c != etalon)
+                        throw std::runtime_error ("test");
+                };
+
+            for (size_t threads : {1, 3})
+            {
+                check (ScalarKernel<AsmSolution> {}, threads);
+                check (ScalarKernel<MagicSolution> {}, threads);
+                check (Avx2Kernel {}, threads);
+                check (Avx512Kernel {}, threads);
+            }
+        }
+    }
+}
+
+BENCHMARK (BM_BinaryGemmCheck);
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Reversing the bit order of 32- and 64-bit words, bit 0 trading places with the top bit.
+// Every Solution has Reverse overloads for both widths; ReverseBulk<Solution> runs over arrays,
+// with the vector Solutions specializing it.
+
+struct NaiveReverseSolution
+{
+    template <class T>
+    static constexpr T Reverse (T n) noexcept
+    {
+        T res = 0;
+        for (size_t ii = 0; ii < sizeof (T) * 8; ++ii, n >>= 1)
+            res = (res << 1) | (n & 1);
+        return res;
+    }
+};
+
+template <size_t TableSize>
+constexpr static auto ReverseTable() noexcept
+{
+    std::array<uint8_t, TableSize> res = {0,};
+    constexpr size_t bits = TableSize == 256 ? 8 : 4;
+    for (size_t ii = 0; ii < res.size(); ++ii)
+        res[ii] = static_cast<uint8_t> (NaiveReverseSolution::Reverse (static_cast<uint32_t> (ii)) >> (32 - bits));
+    return res;
+}
+
+struct ByteTableReverseSolution
+{
+    template <class T>
+    static constexpr T Reverse (T n) noexcept
+    {
+        T res = 0;
+        for (size_t ii = 0; ii < sizeof (T); ++ii, n >>= 8)
+            res = (res << 8) | g_table[n & 0xFF];
+        return res;
+    }
+
+private:
+    constexpr static auto g_table = ReverseTable<256>();
+};
+
+// Swaps adjacent bits, then pairs, nibbles and so on up to halves
+struct SwarReverseSolution
+{
+    static constexpr uint32_t Reverse (uint32_t n) noexcept
+    {
+        n = ((n >> 1) & 0x55555555) | ((n & 0x55555555) << 1);
+        n = ((n >> 2) & 0x33333333) | ((n & 0x33333333) << 2);
+        n = ((n >> 4) & 0x0F0F0F0F) | ((n & 0x0F0F0F0F) << 4);
+        n = ((n >> 8) & 0x00FF00FF) | ((n & 0x00FF00FF) << 8);
+        return (n >> 16) | (n << 16);
+    }
+
+    static constexpr uint64_t Reverse (uint64_t n) noexcept
+    {
+        n = ((n >> 1) & 0x5555555555555555) | ((n & 0x5555555555555555) << 1);
+        n = ((n >> 2) & 0x3333333333333333) | ((n & 0x3333333333333333) << 2);
+        n = ((n >> 4) & 0x0F0F0F0F0F0F0F0F) | ((n & 0x0F0F0F0F0F0F0F0F) << 4);
+        n = ((n >> 8) & 0x00FF00FF00FF00FF) | ((n & 0x00FF00FF00FF00FF) << 8);
+        n = ((n >> 16) & 0x0000FFFF0000FFFF) | ((n & 0x0000FFFF0000FFFF) << 16);
+        return (n >> 32) | (n << 32);
+    }
+};
+
+// bswap puts the bytes in order, a 16-entry table reverses each nibble, nibble pairs swap
+struct BswapNibbleReverseSolution
+{
+    template <class T>
+    static constexpr T Reverse (T n) noexcept
+    {
+        if constexpr (sizeof (T) == 4)
+            n = __builtin_bswap32 (n);
+        else
+            n = __builtin_bswap64 (n);
+
+        T res = 0;
+        for (size_t ii = 0; ii < sizeof (T) * 8; ii += 8)
+            res |= (static_cast<T> (g_table[(n >> ii) & 0xF]) << (ii + 4)) |
+                (static_cast<T> (g_table[(n >> (ii + 4)) & 0xF]) << ii);
+        return res;
+    }
+
+private:
+    constexpr static auto g_table = ReverseTable<16>();
+};
+
+template <class Solution, class T>
+void ReverseBulk (const T* in, T* out, size_t size) noexcept
+{
+    for (size_t ii = 0; ii < size; ++ii)
+        out[ii] = Solution::Reverse (in[ii]);
+}
+
+// Bulk: vpshufb reverses byte order within each word, then the bits of every byte with two
+// vpshufb nibble lookups, the same nibble trick as CountBulkAvx2
+struct Avx2ReverseSolution : SwarReverseSolution
+{
+};
+
+// Bulk: vgf2p8affineqb with the anti-diagonal matrix reverses the bits of every byte in one
+// instruction, vpshufb the byte order
+struct Gf2ReverseSolution : SwarReverseSolution
+{
+};
+
+template <class T>
+__attribute__((target("avx2")))
+inline __m256i ByteOrderReverse() noexcept
+{
+    if constexpr (sizeof (T) == 4)
+        return _mm256_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    else
+        return _mm256_setr_epi8 (7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+}
+
+template <class T>
+__attribute__((target("avx2")))
+void ReverseBulkAvx2 (const T* in, T* out, size_t size) noexcept
+{
+    const auto order = ByteOrderReverse<T>();
+    // Reversed nibbles, low nibble to high position and vice versa
+    const auto lowToHigh = _mm256_setr_epi8 (0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
+                                             0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0);
+    const auto highToLow = _mm256_setr_epi8 (0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF,
+                                             0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF);
+    const auto nibble = _mm256_set1_epi8 (0x0F);
+
+    constexpr size_t step = 32 / sizeof (T);
+    size_t ii = 0;
+    for (; ii + step <= size; ii += step)
+    {
+        const auto v = _mm256_shuffle_epi8 (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (in + ii)), order);
+        const auto lo = _mm256_shuffle_epi8 (lowToHigh, _mm256_and_si256 (v, nibble));
+        const auto hi = _mm256_shuffle_epi8 (highToLow, _mm256_and_si256 (_mm256_srli_epi16 (v, 4), nibble));
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (out + ii), _mm256_or_si256 (lo, hi));
+    }
+
+    ReverseBulk<SwarReverseSolution> (in + ii, out + ii, size - ii);
+}
+
+template <class T>
+__attribute__((target("avx2,gfni")))
+void ReverseBulkGf2 (const T* in, T* out, size_t size) noexcept
+{
+    const auto order = ByteOrderReverse<T>();
+    // Row i of the bit matrix picks input bit 7 - i
+    const auto reverse = _mm256_set1_epi64x (0x8040201008040201);
+
+    constexpr size_t step = 32 / sizeof (T);
+    size_t ii = 0;
+    for (; ii + step <= size; ii += step)
+    {
+        const auto v = _mm256_shuffle_epi8 (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (in + ii)), order);
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (out + ii), _mm256_gf2p8affine_epi64_epi8 (v, reverse, 0));
+    }
+
+    ReverseBulk<SwarReverseSolution> (in + ii, out + ii, size - ii);
+}
+
+template <>
+inline void ReverseBulk<Avx2ReverseSolution, uint32_t> (const uint32_t* in, uint32_t* out, size_t size) noexcept
+{
+    static const bool hasAvx2 = __builtin_cpu_supports ("avx2");
+    hasAvx2 ? ReverseBulkAvx2 (in, out, size) : ReverseBulk<SwarReverseSolution> (in, out, size);
+}
+
+template <>
+inline void ReverseBulk<Avx2ReverseSolution, uint64_t> (const uint64_t* in, uint64_t* out, size_t size) noexcept
+{
+    static const bool hasAvx2 = __builtin_cpu_supports ("avx2");
+    hasAvx2 ? ReverseBulkAvx2 (in, out, size) : ReverseBulk<SwarReverseSolution> (in, out, size);
+}
+
+inline bool HasGfni() noexcept
+{
+    static const bool hasGfni = __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("gfni");
+    return hasGfni;
+}
+
+template <>
+inline void ReverseBulk<Gf2ReverseSolution, uint32_t> (const uint32_t* in, uint32_t* out, size_t size) noexcept
+{
+    HasGfni() ? ReverseBulkGf2 (in, out, size) : ReverseBulk<Avx2ReverseSolution> (in, out, size);
+}
+
+template <>
+inline void ReverseBulk<Gf2ReverseSolution, uint64_t> (const uint64_t* in, uint64_t* out, size_t size) noexcept
+{
+    HasGfni() ? ReverseBulkGf2 (in, out, size) : ReverseBulk<Avx2ReverseSolution> (in, out, size);
+}
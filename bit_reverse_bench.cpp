@@ -0,0 +1,111 @@
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bit_reverse.h"
+
+namespace
+{
+
+template <class T>
+std::vector<T> GenerateWords (size_t size)
+{
+    std::mt19937_64 gen(42);
+    std::vector<T> res (size);
+    for (auto& word : res)
+        word = static_cast<T> (gen());
+    return res;
+}
+
+}
+
+// Arg: array length
+template <class Solution, class T>
+void BM_ReverseBulk (benchmark::State &state)
+{
+    const auto in = GenerateWords<T> (state.range (0));
+    std::vector<T> out (in.size());
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        ReverseBulk<Solution> (in.data(), out.data(), in.size());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * in.size());
+    state.SetBytesProcessed (state.iterations() * in.size() * sizeof (T));
+}
+
+// L2 resident, then far past LLC
+#define REVERSE(Solution) \
+    BENCHMARK_TEMPLATE(BM_ReverseBulk, Solution, uint32_t)->Arg (1 << 16)->Arg (1 << 26); \
+    BENCHMARK_TEMPLATE(BM_ReverseBulk, Solution, uint64_t)->Arg (1 << 15)->Arg (1 << 25);
+
+REVERSE(NaiveReverseSolution)
+REVERSE(ByteTableReverseSolution)
+REVERSE(SwarReverseSolution)
+REVERSE(BswapNibbleReverseSolution)
+REVERSE(Avx2ReverseSolution)
+REVERSE(Gf2ReverseSolution)
+
+#undef REVERSE
+
+// Every 32-bit word through every bulk kernel against the byte table, which is itself checked
+// against the naive loop on a stride; 64-bit words by samples and by halves
+void BM_ReverseCheck (benchmark::State &state)
+{
+    constexpr size_t chunk = 1 << 16;
+    std::vector<uint32_t> in (chunk), etalon (chunk), out (chunk);
+
+    const auto check = [&](auto solution)
+        {
+            ReverseBulk<decltype (solution)> (in.data(), out.data(), in.size());
+            if (out != etalon)
+                throw std::runtime_error ("test");
+        };
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (uint64_t first = 0; first < (uint64_t (1) << 32); first += chunk)
+        {
+            std::iota (in.begin(), in.end(), static_cast<uint32_t> (first));
+            ReverseBulk<ByteTableReverseSolution> (in.data(), etalon.data(), in.size());
+            if (NaiveReverseSolution::Reverse (in[first % 251]) != etalon[first % 251])
+                throw std::runtime_error ("test");
+
+            check (SwarReverseSolution {});
+            check (BswapNibbleReverseSolution {});
+            check (Avx2ReverseSolution {});
+            check (Gf2ReverseSolution {});
+        }
+
+        const auto words = GenerateWords<uint64_t> (100003);
+        std::vector<uint64_t> wide (words.size());
+        const auto checkWide = [&](auto solution)
+            {
+                ReverseBulk<decltype (solution)> (words.data(), wide.data(), words.size());
+                for (size_t ii = 0; ii < words.size(); ++ii)
+                {
+                    const auto expected = (uint64_t (NaiveReverseSolution::Reverse (static_cast<uint32_t> (words[ii]))) << 32) |
+                        NaiveReverseSolution::Reverse (static_cast<uint32_t> (words[ii] >> 32));
+                    if (wide[ii] != expected || NaiveReverseSolution::Reverse (words[ii]) != expected)
+                        throw std::runtime_error ("test");
+                }
+            };
+
+        checkWide (ByteTableReverseSolution {});
+        checkWide (SwarReverseSolution {});
+        checkWide (BswapNibbleReverseSolution {});
+        checkWide (Avx2ReverseSolution {});
+        checkWide (Gf2ReverseSolution {});
+    }
+}
+
+BENCHMARK (BM_ReverseCheck)->Iterations (1)->Unit (benchmark::kSecond);
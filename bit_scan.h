@@ -0,0 +1,249 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "count_bits.h"
+
+// Leading / trailing zero count, parity and find-first-set of a 32-bit word, one Solution per
+// implementation strategy. Zero is defined everywhere: Clz and Ctz give 32, Ffs gives 0,
+// Ffs is otherwise 1 + Ctz as with POSIX ffs.
+
+struct ReferenceScanSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static constexpr uint32_t Clz (uint32_t n) noexcept
+    {
+        uint32_t res = 0;
+        for (uint32_t bit = 1u << 31; bit && !(n & bit); bit >>= 1)
+            ++res;
+        return res;
+    }
+
+    static constexpr uint32_t Ctz (uint32_t n) noexcept
+    {
+        uint32_t res = 0;
+        for (uint32_t bit = 1; bit && !(n & bit); bit <<= 1)
+            ++res;
+        return res;
+    }
+
+    static constexpr uint32_t Parity (uint32_t n) noexcept
+    {
+        uint32_t res = 0;
+        for (; n; n >>= 1)
+            res ^= n & 1;
+        return res;
+    }
+
+    static constexpr uint32_t Ffs (uint32_t n) noexcept
+    {
+        return n ? Ctz (n) + 1 : 0;
+    }
+};
+
+// Position of the single set bit, or of the top bit of a smeared word, by de Bruijn hash
+template <uint32_t Multiplier, bool Smeared>
+constexpr static auto DeBruijnTable() noexcept
+{
+    std::array<uint8_t, 32> res = {0,};
+    for (uint32_t ii = 0; ii < 32; ++ii)
+    {
+        const auto v = Smeared ? static_cast<uint32_t> ((uint64_t (2) << ii) - 1) : 1u << ii;
+        res[(v * Multiplier) >> 27] = ii;
+    }
+    return res;
+}
+
+template <class Op>
+constexpr static auto ByteScanTable (Op op) noexcept
+{
+    std::array<uint8_t, 256> res = {0,};
+    for (uint32_t ii = 0; ii < res.size(); ++ii)
+        res[ii] = op (ii);
+    return res;
+}
+
+// lzcnt / tzcnt, defined for zero. Spelled in asm to keep -mlzcnt -mbmi away from every
+// includer; on CPUs without them the same encodings run as bsr / bsf, hence Available().
+struct IntrinsicScanSolution
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("abm") && __builtin_cpu_supports ("bmi");
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Clz (uint32_t n) noexcept
+    {
+        uint32_t res;
+        asm ("lzcnt %1, %0" : "=r" (res) : "rm" (n) : "cc");
+        return res;
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Ctz (uint32_t n) noexcept
+    {
+        uint32_t res;
+        asm ("tzcnt %1, %0" : "=r" (res) : "rm" (n) : "cc");
+        return res;
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Parity (uint32_t n) noexcept
+    {
+        return AsmSolution::Count (n) & 1;
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Ffs (uint32_t n) noexcept
+    {
+        return n ? Ctz (n) + 1 : 0;
+    }
+};
+
+// bsr / bsf, which leave the destination undefined for zero, so zero is tested first; parity
+// from the parity flag of the folded low byte
+struct BsrScanSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Clz (uint32_t n) noexcept
+    {
+        uint32_t res;
+        asm ("bsr %1, %0" : "=r" (res) : "rm" (n) : "cc");
+        return n ? 31 - res : 32;
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Ctz (uint32_t n) noexcept
+    {
+        uint32_t res;
+        asm ("bsf %1, %0" : "=r" (res) : "rm" (n) : "cc");
+        return n ? res : 32;
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Parity (uint32_t n) noexcept
+    {
+        n ^= n >> 16;
+        n ^= n >> 8;
+        uint8_t odd;
+        asm ("test %1, %1\n\tsetnp %0" : "=r" (odd) : "q" (static_cast<uint8_t> (n)) : "cc");
+        return odd;
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Ffs (uint32_t n) noexcept
+    {
+        return n ? Ctz (n) + 1 : 0;
+    }
+};
+
+// Isolated lowest bit, or the word smeared right from its highest bit, times a de Bruijn
+// constant has a distinct top five bits per position, looked up in a 32-entry table
+struct DeBruijnScanSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static constexpr uint32_t Clz (uint32_t n) noexcept
+    {
+        auto v = n;
+        v |= v >> 1;
+        v |= v >> 2;
+        v |= v >> 4;
+        v |= v >> 8;
+        v |= v >> 16;
+        return n ? 31 - g_highTable[(v * g_highMultiplier) >> 27] : 32;
+    }
+
+    static constexpr uint32_t Ctz (uint32_t n) noexcept
+    {
+        return n ? g_lowTable[((n & (0 - n)) * g_lowMultiplier) >> 27] : 32;
+    }
+
+    // 0x6996 is the parity of every nibble value
+    static constexpr uint32_t Parity (uint32_t n) noexcept
+    {
+        n ^= n >> 16;
+        n ^= n >> 8;
+        n ^= n >> 4;
+        return (0x6996 >> (n & 0xF)) & 1;
+    }
+
+    static constexpr uint32_t Ffs (uint32_t n) noexcept
+    {
+        return n ? Ctz (n) + 1 : 0;
+    }
+
+private:
+    static constexpr uint32_t g_lowMultiplier = 0x077CB531u;
+    static constexpr uint32_t g_highMultiplier = 0x07C4ACDDu;
+
+    constexpr static auto g_lowTable = DeBruijnTable<g_lowMultiplier, false>();
+    constexpr static auto g_highTable = DeBruijnTable<g_highMultiplier, true>();
+};
+
+// Per-byte tables, scanning bytes from the end the count starts at
+struct ByteTableScanSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static constexpr uint32_t Clz (uint32_t n) noexcept
+    {
+        if (n >> 16)
+            return n >> 24 ? g_clz[n >> 24] : 8 + g_clz[n >> 16];
+        return n >> 8 ? 16 + g_clz[n >> 8] : 24 + g_clz[n & 0xFF];
+    }
+
+    static constexpr uint32_t Ctz (uint32_t n) noexcept
+    {
+        if (n & 0xFFFF)
+            return n & 0xFF ? g_ctz[n & 0xFF] : 8 + g_ctz[(n >> 8) & 0xFF];
+        return n & 0xFF0000 ? 16 + g_ctz[(n >> 16) & 0xFF] : 24 + g_ctz[n >> 24];
+    }
+
+    static constexpr uint32_t Parity (uint32_t n) noexcept
+    {
+        n ^= n >> 16;
+        return g_parity[(n ^ (n >> 8)) & 0xFF];
+    }
+
+    static constexpr uint32_t Ffs (uint32_t n) noexcept
+    {
+        return n ? Ctz (n) + 1 : 0;
+    }
+
+private:
+    // Counts within a byte, 8 for a zero byte
+    constexpr static auto g_clz = ByteScanTable ([](uint32_t b) { return ReferenceScanSolution::Clz (b << 24) - (b ? 0 : 24); });
+    constexpr static auto g_ctz = ByteScanTable ([](uint32_t b) { return b ? ReferenceScanSolution::Ctz (b) : 8; });
+    constexpr static auto g_parity = ByteScanTable ([](uint32_t b) { return ReferenceScanSolution::Parity (b); });
+};
+
+// Writes the index of every set bit of data[0, size) into out, in increasing order, returns
+// how many were written; out must have room for 32 * size
+template <class Solution>
+size_t SetBitPositions (const uint32_t* data, size_t size, uint32_t* out) noexcept
+{
+    size_t res = 0;
+    for (size_t ii = 0; ii < size; ++ii)
+        for (auto word = data[ii]; word; word &= word - 1)
+            out[res++] = static_cast<uint32_t> (ii * 32) + Solution::Ctz (word);
+    return res;
+}
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bit_scan.h"
+
+namespace
+{
+
+// Uniform words almost always have their top and bottom bits set, so lengths and offsets
+// are drawn too, and every operation sees all of its outcomes
+std::vector<uint32_t> GenerateScanNumbers (size_t size)
+{
+    std::mt19937 gen(42);
+    std::vector<uint32_t> res (size);
+    for (auto& num : res)
+        num = (gen() >> (gen() % 32)) << (gen() % 32);
+    return res;
+}
+
+// Each bit set with probability percent / 100
+std::vector<uint32_t> GenerateBitmap (size_t words, int percent)
+{
+    std::mt19937 gen(42);
+    std::bernoulli_distribution dist(percent / 100.0);
+    std::vector<uint32_t> res (words);
+    for (auto& word : res)
+        for (uint32_t bit = 0; bit < 32; ++bit)
+            word |= static_cast<uint32_t> (dist(gen)) << bit;
+    return res;
+}
+
+struct Clz { template <class Solution> static uint32_t Apply (uint32_t n) noexcept { return Solution::Clz (n); } };
+struct Ctz { template <class Solution> static uint32_t Apply (uint32_t n) noexcept { return Solution::Ctz (n); } };
+struct Parity { template <class Solution> static uint32_t Apply (uint32_t n) noexcept { return Solution::Parity (n); } };
+struct Ffs { template <class Solution> static uint32_t Apply (uint32_t n) noexcept { return Solution::Ffs (n); } };
+
+}
+
+template <class Solution, class Op>
+void BM_Scan (benchmark::State &state)
+{
+    if (!Solution::Available())
+    {
+        state.SkipWithError ("solution not supported by this cpu");
+        return;
+    }
+
+    const auto nums = GenerateScanNumbers (100000);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (auto num : nums)
+            benchmark::DoNotOptimize (Op::template Apply<Solution> (num));
+        state.SetItemsProcessed (state.items_processed() + nums.size());
+    }
+}
+
+#define SCAN(Op) \
+    BENCHMARK_TEMPLATE(BM_Scan, ReferenceScanSolution, Op)->ThreadRange (1, 8); \
+    BENCHMARK_TEMPLATE(BM_Scan, IntrinsicScanSolution, Op)->ThreadRange (1, 8); \
+    BENCHMARK_TEMPLATE(BM_Scan, BsrScanSolution, Op)->ThreadRange (1, 8); \
+    BENCHMARK_TEMPLATE(BM_Scan, DeBruijnScanSolution, Op)->ThreadRange (1, 8); \
+    BENCHMARK_TEMPLATE(BM_Scan, ByteTableScanSolution, Op)->ThreadRange (1, 8);
+
+SCAN(Clz)
+SCAN(Ctz)
+SCAN(Parity)
+SCAN(Ffs)
+
+#undef SCAN
+
+// Arg: percent of bits set; items are positions written
+template <class Solution>
+void BM_SetBitPositions (benchmark::State &state)
+{
+    if (!Solution::Available())
+    {
+        state.SkipWithError ("solution not supported by this cpu");
+        return;
+    }
+
+    const auto bitmap = GenerateBitmap (1 << 16, state.range (0));
+    std::vector<uint32_t> positions (bitmap.size() * 32);
+    size_t written = 0;
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        written += SetBitPositions<Solution> (bitmap.data(), bitmap.size(), positions.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (written);
+    state.SetBytesProcessed (state.iterations() * bitmap.size() * sizeof (uint32_t));
+}
+
+#define SET_BIT_DENSITIES Arg (1)->Arg (10)->Arg (50)->Arg (90)
+
+BENCHMARK_TEMPLATE(BM_SetBitPositions, ReferenceScanSolution)->SET_BIT_DENSITIES;
+BENCHMARK_TEMPLATE(BM_SetBitPositions, IntrinsicScanSolution)->SET_BIT_DENSITIES;
+BENCHMARK_TEMPLATE(BM_SetBitPositions, BsrScanSolution)->SET_BIT_DENSITIES;
+BENCHMARK_TEMPLATE(BM_SetBitPositions, DeBruijnScanSolution)->SET_BIT_DENSITIES;
+BENCHMARK_TEMPLATE(BM_SetBitPositions, ByteTableScanSolution)->SET_BIT_DENSITIES;
+
+#undef SET_BIT_DENSITIES
+
+namespace
+{
+
+template <class Solution>
+bool ScanMatches (uint32_t num) noexcept
+{
+    return Solution::Clz (num) == ReferenceScanSolution::Clz (num) &&
+        Solution::Ctz (num) == ReferenceScanSolution::Ctz (num) &&
+        Solution::Parity (num) == ReferenceScanSolution::Parity (num) &&
+        Solution::Ffs (num) == ReferenceScanSolution::Ffs (num);
+}
+
+}
+
+void BM_ScanCheck (benchmark::State &state)
+{
+    auto nums = GenerateScanNumbers (100000);
+    for (uint32_t bit = 0; bit < 32; ++bit)
+    {
+        nums.push_back (1u << bit);
+        nums.push_back (~0u << bit);
+        nums.push_back (~0u >> bit);
+    }
+    nums.push_back (0);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (auto num : nums)
+            if ((IntrinsicScanSolution::Available() && !ScanMatches<IntrinsicScanSolution> (num)) ||
+                !ScanMatches<BsrScanSolution> (num) ||
+                !ScanMatches<DeBruijnScanSolution> (num) ||
+                !ScanMatches<ByteTableScanSolution> (num) ||
+                ReferenceScanSolution::Ffs (num) != static_cast<uint32_t> (__builtin_ffs (static_cast<int> (num))))
+                throw std::runtime_error ("test");
+
+        const auto bitmap = GenerateBitmap (1001, 30);
+        std::vector<uint32_t> etalon, positions (bitmap.size() * 32);
+        for (size_t ii = 0; ii < bitmap.size() * 32; ++ii)
+            if ((bitmap[ii / 32] >> (ii % 32)) & 1)
+                etalon.push_back (ii);
+
+        const auto check = [&](size_t written)
+            {
+                if (!std::equal (etalon.begin(), etalon.end(), positions.begin(), positions.begin() + written))
+                    throw std::runtime_error ("test");
+            };
+        check (SetBitPositions<ReferenceScanSolution> (bitmap.data(), bitmap.size(), positions.data()));
+        check (SetBitPositions<BsrScanSolution> (bitmap.data(), bitmap.size(), positions.data()));
+        check (SetBitPositions<DeBruijnScanSolution> (bitmap.data(), bitmap.size(), positions.data()));
+        check (SetBitPositions<ByteTableScanSolution> (bitmap.data(), bitmap.size(), positions.data()));
+        if (IntrinsicScanSolution::Available())
+            check (SetBitPositions<IntrinsicScanSolution> (bitmap.data(), bitmap.size(), positions.data()));
+
+        state.SetItemsProcessed (state.items_processed() + nums.size());
+    }
+}
+
+BENCHMARK (BM_ScanCheck);
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "count_bits.h"
+
+// Select: position of the set bit of a given rank, counted from 0 at the low end, the inverse
+// of popcount over a prefix. Rank must be below the popcount of the word.
+
+struct ReferenceSelectSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static uint32_t Select (uint64_t word, uint32_t rank) noexcept
+    {
+        for (; rank; --rank)
+            word &= word - 1;
+        return __builtin_ctzll (word);
+    }
+};
+
+// Deposits a single bit at the rank-th set position of the word and finds it. PDEP is
+// microcoded on AMD before Zen 3, tens of cycles, hence the broadword alternative.
+struct PdepSelectSolution
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("bmi2") && __builtin_cpu_supports ("bmi");
+    }
+
+    __attribute__((always_inline))
+    static uint32_t Select (uint64_t word, uint32_t rank) noexcept
+    {
+        uint64_t deposited;
+        asm ("pdep %2, %1, %0" : "=r" (deposited) : "r" (uint64_t (1) << rank), "rm" (word));
+        uint64_t res;
+        asm ("tzcnt %1, %0" : "=r" (res) : "rm" (deposited) : "cc");
+        return static_cast<uint32_t> (res);
+    }
+};
+
+// Every in-byte select answer, indexed [byte][rank]
+constexpr static auto SelectInByteTable() noexcept
+{
+    std::array<std::array<uint8_t, 8>, 256> res = {};
+    for (uint32_t byte = 0; byte < 256; ++byte)
+    {
+        uint32_t rank = 0;
+        for (uint32_t bit = 0; bit < 8; ++bit)
+            if ((byte >> bit) & 1)
+                res[byte][rank++] = bit;
+    }
+    return res;
+}
+
+constexpr static auto g_selectInByte = SelectInByteTable();
+
+// After Vigna: byte-wise popcount times 0x0101... gives inclusive prefix counts in every byte,
+// subtracting them from rank in every byte at once tells how many bytes lie wholly below the
+// answer, the last step selects inside that byte
+struct BroadwordSelectSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static uint32_t Select (uint64_t word, uint32_t rank) noexcept
+    {
+        constexpr uint64_t ones = 0x0101010101010101;
+        constexpr uint64_t msbs = 0x8080808080808080;
+
+        auto s = word - ((word >> 1) & 0x5555555555555555);
+        s = (s & 0x3333333333333333) + ((s >> 2) & 0x3333333333333333);
+        const auto prefix = ((s + (s >> 4)) & 0x0F0F0F0F0F0F0F0F) * ones;
+
+        const auto below = (((rank * ones) | msbs) - prefix) & msbs;
+        const auto place = static_cast<uint32_t> (AsmSolution::Count (static_cast<uint32_t> (below)) +
+            AsmSolution::Count (static_cast<uint32_t> (below >> 32))) * 8;
+        const auto byteRank = rank - static_cast<uint32_t> (((prefix << 8) >> place) & 0xFF);
+        return place + g_selectInByte[(word >> place) & 0xFF][byteRank];
+    }
+};
+
+// Popcount of each byte from a table until the byte holding the rank, then the same in-byte table
+struct ByteTableSelectSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static uint32_t Select (uint64_t word, uint32_t rank) noexcept
+    {
+        uint32_t place = 0;
+        for (;; place += 8, word >>= 8)
+        {
+            const auto count = ByteTableSolution::Table()[word & 0xFF];
+            if (rank < count)
+                break;
+            rank -= count;
+        }
+        return place + g_selectInByte[word & 0xFF][rank];
+    }
+};
+
+// Bitmap to positions: the index of every set bit of words[0, size), in increasing order.
+// out needs room for every set bit plus g_decodeSlack entries the vector decoder overwrites.
+constexpr size_t g_decodeSlack = 16;
+
+struct ScalarDecoder
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static size_t Decode (const uint64_t* words, size_t size, uint32_t* out) noexcept
+    {
+        size_t res = 0;
+        for (size_t ii = 0; ii < size; ++ii)
+            for (auto word = words[ii]; word; word &= word - 1)
+                out[res++] = static_cast<uint32_t> (ii * 64 + __builtin_ctzll (word));
+        return res;
+    }
+};
+
+// vpcompressd packs the lanes of 16 consecutive positions whose bit is set, a full store
+// writes them, and the output pointer advances by their popcount. Words with few bits set
+// take the scalar loop, which is then fewer steps than the four 16-bit chunks.
+struct Avx512Decoder
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx512f");
+    }
+
+    __attribute__((target("avx512f")))
+    static size_t Decode (const uint64_t* words, size_t size, uint32_t* out) noexcept
+    {
+        const auto lanes = _mm512_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const auto sixteen = _mm512_set1_epi32 (16);
+
+        size_t res = 0;
+        for (size_t ii = 0; ii < size; ++ii)
+        {
+            auto word = words[ii];
+            if (__builtin_popcountll (word) <= g_sparse)
+            {
+                for (; word; word &= word - 1)
+                    out[res++] = static_cast<uint32_t> (ii * 64 + __builtin_ctzll (word));
+                continue;
+            }
+
+            auto base = _mm512_add_epi32 (lanes, _mm512_set1_epi32 (static_cast<int> (ii * 64)));
+            for (; word; word >>= 16, base = _mm512_add_epi32 (base, sixteen))
+            {
+                const auto mask = static_cast<__mmask16> (word);
+                _mm512_storeu_si512 (out + res, _mm512_maskz_compress_epi32 (mask, base));
+                res += AsmSolution::Count (mask);
+            }
+        }
+        return res;
+    }
+
+private:
+    static constexpr int g_sparse = 4;
+};
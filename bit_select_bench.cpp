@@ -0,0 +1,146 @@
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bit_select.h"
+
+namespace
+{
+
+// Each bit set with probability percent / 100
+std::vector<uint64_t> GenerateBitmap (size_t words, int percent, uint32_t seed = 42)
+{
+    std::mt19937_64 gen(seed);
+    std::bernoulli_distribution dist(percent / 100.0);
+    std::vector<uint64_t> res (words);
+    for (auto& word : res)
+        for (uint32_t bit = 0; bit < 64; ++bit)
+            word |= static_cast<uint64_t> (dist(gen)) << bit;
+    return res;
+}
+
+struct Query
+{
+    uint64_t word;
+    uint32_t rank;
+};
+
+// Non-empty words of the given density, each with a valid rank
+std::vector<Query> GenerateQueries (size_t size, int percent)
+{
+    std::mt19937 gen(7);
+    std::vector<Query> res;
+    for (auto word : GenerateBitmap (size * 2, percent))
+        if (word && res.size() < size)
+            res.push_back ({word, static_cast<uint32_t> (gen() % __builtin_popcountll (word))});
+    return res;
+}
+
+}
+
+// Arg: percent of bits set
+template <class Solution>
+void BM_Select (benchmark::State &state)
+{
+    if (!Solution::Available())
+    {
+        state.SkipWithError ("solution not supported by this cpu");
+        return;
+    }
+
+    const auto queries = GenerateQueries (1 << 16, state.range (0));
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (const auto& query : queries)
+            benchmark::DoNotOptimize (Solution::Select (query.word, query.rank));
+    }
+
+    state.SetItemsProcessed (state.iterations() * queries.size());
+}
+
+#define SELECT_DENSITIES Arg (5)->Arg (50)->Arg (95)
+
+BENCHMARK_TEMPLATE(BM_Select, ReferenceSelectSolution)->SELECT_DENSITIES;
+BENCHMARK_TEMPLATE(BM_Select, PdepSelectSolution)->SELECT_DENSITIES;
+BENCHMARK_TEMPLATE(BM_Select, BroadwordSelectSolution)->SELECT_DENSITIES;
+BENCHMARK_TEMPLATE(BM_Select, ByteTableSelectSolution)->SELECT_DENSITIES;
+
+#undef SELECT_DENSITIES
+
+// Arg: percent of bits set; items are positions decoded
+template <class Decoder>
+void BM_DecodePositions (benchmark::State &state)
+{
+    if (!Decoder::Available())
+    {
+        state.SkipWithError ("decoder not supported by this cpu");
+        return;
+    }
+
+    const auto bitmap = GenerateBitmap (1 << 14, state.range (0));
+    std::vector<uint32_t> positions (bitmap.size() * 64 + g_decodeSlack);
+    size_t decoded = 0;
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        decoded += Decoder::Decode (bitmap.data(), bitmap.size(), positions.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (decoded);
+    state.SetBytesProcessed (state.iterations() * bitmap.size() * sizeof (uint64_t));
+}
+
+#define DECODE_DENSITIES Arg (1)->Arg (3)->Arg (10)->Arg (25)->Arg (50)->Arg (75)->Arg (99)
+
+BENCHMARK_TEMPLATE(BM_DecodePositions, ScalarDecoder)->DECODE_DENSITIES;
+BENCHMARK_TEMPLATE(BM_DecodePositions, Avx512Decoder)->DECODE_DENSITIES;
+
+#undef DECODE_DENSITIES
+
+void BM_SelectCheck (benchmark::State &state)
+{
+    std::vector<uint64_t> words = {1, uint64_t (1) << 63, ~uint64_t (0), 0x8000000000000001, 0x00FF00000000FF00};
+    for (int percent : {2, 30, 70, 98})
+        for (auto word : GenerateBitmap (2000, percent))
+            words.push_back (word);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (auto word : words)
+            for (uint32_t rank = 0; rank < static_cast<uint32_t> (__builtin_popcountll (word)); ++rank)
+            {
+                const auto etalon = ReferenceSelectSolution::Select (word, rank);
+                if ((PdepSelectSolution::Available() && PdepSelectSolution::Select (word, rank) != etalon) ||
+                    BroadwordSelectSolution::Select (word, rank) != etalon ||
+                    ByteTableSelectSolution::Select (word, rank) != etalon)
+                    throw std::runtime_error ("test");
+            }
+
+        for (int percent : {0, 1, 50, 100})
+        {
+            const auto bitmap = GenerateBitmap (1001, percent, percent);
+            std::vector<uint32_t> etalon (bitmap.size() * 64 + g_decodeSlack), positions (etalon.size());
+            const auto count = ScalarDecoder::Decode (bitmap.data(), bitmap.size(), etalon.data());
+            for (size_t ii = 0, pos = 0; ii < bitmap.size() * 64; ++ii)
+                if ((bitmap[ii / 64] >> (ii % 64)) & 1)
+                    if (etalon[pos++] != ii)
+                        throw std::runtime_error ("test");
+
+            if (Avx512Decoder::Available() &&
+                (Avx512Decoder::Decode (bitmap.data(), bitmap.size(), positions.data()) != count ||
+                 !std::equal (etalon.begin(), etalon.begin() + count, positions.begin())))
+                throw std::runtime_error ("test");
+        }
+    }
+}
+
+BENCHMARK (BM_SelectCheck);
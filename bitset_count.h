@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+#include <boost/dynamic_bitset/serialization.hpp>
+
+#include "count_bits.h"
+
+// Popcount of boost::dynamic_bitset<>, std::bitset and std::vector<bool> through the bulk
+// Solution kernels, run in place over each container's word storage. The kernels only read
+// it, as uint32_t pairs.
+
+namespace bitset_count
+{
+
+using Word = unsigned long;
+
+static_assert (sizeof (Word) == 2 * sizeof (uint32_t), "words are counted as uint32_t pairs");
+
+template <class Solution>
+uint64_t CountWords (const Word* words, size_t size) noexcept
+{
+    return CountBulk<Solution> (reinterpret_cast<const uint32_t*> (words), size * 2);
+}
+
+// Ones among the low `bits` bits of word
+template <class Solution>
+uint64_t CountPartial (Word word, size_t bits) noexcept
+{
+    uint32_t halves[2];
+    word &= (Word (1) << bits) - 1;
+    std::memcpy (halves, &word, sizeof (word));
+    return CountBulk<Solution> (halves, 2);
+}
+
+// dynamic_bitset hands its block vector to serialization archives through serialize_impl,
+// its zero-copy serialization hook; this archive only keeps where the blocks are
+struct BlockArchive
+{
+    template <class T>
+    BlockArchive& operator& (const boost::serialization::nvp<T>& field) noexcept
+    {
+        Take (field.value());
+        return *this;
+    }
+
+    void Take (size_t) noexcept
+    {
+    }
+
+    void Take (const std::vector<Word>& blocks) noexcept
+    {
+        words = blocks.data();
+        size = blocks.size();
+    }
+
+    const Word* words = nullptr;
+    size_t size = 0;
+};
+
+// dynamic_bitset keeps the bits past size() in its last block cleared
+template <class Solution>
+uint64_t Count (const boost::dynamic_bitset<>& bits) noexcept
+{
+    BlockArchive archive;
+    // serialize_impl takes the bitset by non-const reference for loading, but only reads here
+    boost::dynamic_bitset<>::serialize_impl::serialize (archive, const_cast<boost::dynamic_bitset<>&> (bits), 0);
+    return CountWords<Solution> (archive.words, archive.size);
+}
+
+#ifdef __GLIBCXX__
+// libstdc++ lays std::bitset out as its words alone and keeps the bits past Bits cleared
+template <class Solution, size_t Bits>
+uint64_t Count (const std::bitset<Bits>& bits) noexcept
+{
+    constexpr size_t words = (Bits + CHAR_BIT * sizeof (Word) - 1) / (CHAR_BIT * sizeof (Word));
+    static_assert (!words || sizeof (bits) == words * sizeof (Word), "unexpected std::bitset layout");
+
+    return CountWords<Solution> (reinterpret_cast<const Word*> (&bits), words);
+}
+
+// libstdc++ stores std::vector<bool> as whole words starting at begin()._M_p and does not
+// clear the bits past size() in the last one, so they are masked off
+template <class Solution>
+uint64_t Count (const std::vector<bool>& bits) noexcept
+{
+    static_assert (sizeof (std::_Bit_type) == sizeof (Word), "unexpected std::vector<bool> word");
+
+    constexpr size_t wordBits = CHAR_BIT * sizeof (Word);
+    const std::_Bit_type* words = bits.begin()._M_p;
+    const auto full = bits.size() / wordBits;
+
+    auto res = CountWords<Solution> (words, full);
+    if (const auto rest = bits.size() % wordBits)
+        res += CountPartial<Solution> (words[full], rest);
+    return res;
+}
+#else
+// Other standard libraries keep their storage private; count with the containers themselves
+template <class Solution, size_t Bits>
+uint64_t Count (const std::bitset<Bits>& bits) noexcept
+{
+    return bits.count();
+}
+
+template <class Solution>
+uint64_t Count (const std::vector<bool>& bits) noexcept
+{
+    return std::count (bits.begin(), bits.end(), true);
+}
+#endif
+
+}
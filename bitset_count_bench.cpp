@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+#include <boost/dynamic_bitset.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "best_count.h"
+#include "bitset_count.h"
+
+// Native count() of the standard bit containers against the bulk kernels run over their storage
+
+namespace
+{
+
+struct Native {};
+
+template <class Fill>
+void FillRandom (size_t bits, Fill&& fill)
+{
+    std::mt19937 gen(42);
+    std::bernoulli_distribution dist(0.5);
+    for (size_t ii = 0; ii < bits; ++ii)
+        if (dist(gen))
+            fill (ii);
+}
+
+template <class Solution, class Container>
+uint64_t CountWith (const Container& bits)
+{
+    if constexpr (std::is_same_v<Solution, Native>)
+    {
+        if constexpr (std::is_same_v<Container, std::vector<bool>>)
+            return std::count (bits.begin(), bits.end(), true);
+        else
+            return bits.count();
+    }
+    else
+        return bitset_count::Count<Solution> (bits);
+}
+
+}
+
+template <class Solution>
+void BM_DynamicBitsetCount (benchmark::State &state)
+{
+    boost::dynamic_bitset<> bits (state.range (0));
+    FillRandom (bits.size(), [&bits](size_t ii) { bits.set (ii); });
+    CountWith<Solution> (bits); // Heatup table
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        benchmark::DoNotOptimize (CountWith<Solution> (bits));
+    }
+
+    state.SetBytesProcessed (state.iterations() * bits.size() / 8);
+}
+
+template <class Solution>
+void BM_VectorBoolCount (benchmark::State &state)
+{
+    std::vector<bool> bits (state.range (0));
+    FillRandom (bits.size(), [&bits](size_t ii) { bits[ii] = true; });
+    CountWith<Solution> (bits); // Heatup table
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        benchmark::DoNotOptimize (CountWith<Solution> (bits));
+    }
+
+    state.SetBytesProcessed (state.iterations() * bits.size() / 8);
+}
+
+template <class Solution, size_t Bits>
+void BM_BitsetCount (benchmark::State &state)
+{
+    const auto bits = std::make_unique<std::bitset<Bits>>();
+    FillRandom (Bits, [&bits](size_t ii) { bits->set (ii); });
+    CountWith<Solution> (*bits); // Heatup table
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        benchmark::DoNotOptimize (CountWith<Solution> (*bits));
+    }
+
+    state.SetBytesProcessed (state.iterations() * Bits / 8);
+}
+
+#define BITSET_SIZES RangeMultiplier (64)->Range (1 << 10, 1 << 28)
+
+BENCHMARK_TEMPLATE(BM_DynamicBitsetCount, Native)->BITSET_SIZES;
+BENCHMARK_TEMPLATE(BM_DynamicBitsetCount, AsmSolution)->BITSET_SIZES;
+BENCHMARK_TEMPLATE(BM_DynamicBitsetCount, Avx2Solution)->BITSET_SIZES;
+BENCHMARK_TEMPLATE(BM_DynamicBitsetCount, BestCount)->BITSET_SIZES;
+
+BENCHMARK_TEMPLATE(BM_VectorBoolCount, Native)->BITSET_SIZES;
+BENCHMARK_TEMPLATE(BM_VectorBoolCount, AsmSolution)->BITSET_SIZES;
+BENCHMARK_TEMPLATE(BM_VectorBoolCount, Avx2Solution)->BITSET_SIZES;
+BENCHMARK_TEMPLATE(BM_VectorBoolCount, BestCount)->BITSET_SIZES;
+
+#undef BITSET_SIZES
+
+#define BITSET_COUNT(Solution) \
+    BENCHMARK_TEMPLATE(BM_BitsetCount, Solution, 1 << 10); \
+    BENCHMARK_TEMPLATE(BM_BitsetCount, Solution, 1 << 16); \
+    BENCHMARK_TEMPLATE(BM_BitsetCount, Solution, 1 << 22);
+
+BITSET_COUNT(Native)
+BITSET_COUNT(AsmSolution)
+BITSET_COUNT(Avx2Solution)
+BITSET_COUNT(BestCount)
+
+#undef BITSET_COUNT
+
+// Adapters against native count() at sizes that leave a partial last word or vector,
+// including a vector<bool> shrunk so that stale bits remain past its end
+void BM_BitsetCountCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t size : {0, 1, 31, 32, 33, 63, 64, 65, 1000, 4097, 32768, 32769, 100000})
+        {
+            boost::dynamic_bitset<> dynamic (size);
+            std::vector<bool> vector (size + 100, true);
+            vector.resize (size);
+            FillRandom (size, [&dynamic, &vector](size_t ii) { dynamic.set (ii); vector[ii] = false; });
+
+            if (CountWith<Avx2Solution> (dynamic) != dynamic.count() ||
+                CountWith<MagicSolution> (dynamic) != dynamic.count() ||
+                CountWith<Avx2Solution> (vector) != CountWith<Native> (vector) ||
+                CountWith<MagicSolution> (vector) != CountWith<Native> (vector))
+                throw std::runtime_error ("test");
+        }
+
+        const auto bitset = std::make_unique<std::bitset<100000>>();
+        FillRandom (bitset->size(), [&bitset](size_t ii) { bitset->set (ii); });
+        if (CountWith<Avx2Solution> (std::bitset<1> (1)) != 1 ||
+            CountWith<Avx2Solution> (std::bitset<65> ().set()) != 65 ||
+            CountWith<Avx2Solution> (*bitset) != bitset->count() ||
+            CountWith<MagicSolution> (*bitset) != bitset->count())
+            throw std::runtime_error ("test");
+    }
+}
+
+BENCHMARK (BM_BitsetCountCheck);
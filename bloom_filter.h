@@ -0,0 +1,237 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "count_bits.h"
+#include "mix_hash.h"
+
+// Split-block Bloom filter: a key picks one 256-bit block, which never straddles a cache
+// line, and sets one bit in each of its eight 32-bit words, chosen by multiplying the key's
+// low hash half with a per-word odd salt. One block per key makes a lookup one cache miss,
+// eight words make it one AVX2 register.
+
+namespace bloom
+{
+
+constexpr size_t g_blockWords = 8;
+constexpr size_t g_blockBytes = g_blockWords * sizeof (uint32_t);
+
+// Keeps the filter's words on block boundaries
+template <class T>
+struct BlockAllocator
+{
+    using value_type = T;
+
+    BlockAllocator() = default;
+
+    template <class U>
+    BlockAllocator (const BlockAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate (size_t n)
+    {
+        return static_cast<T*> (::operator new (n * sizeof (T), std::align_val_t (g_blockBytes)));
+    }
+
+    void deallocate (T* p, size_t) noexcept
+    {
+        ::operator delete (p, std::align_val_t (g_blockBytes));
+    }
+
+    template <class U>
+    bool operator== (const BlockAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+
+    template <class U>
+    bool operator!= (const BlockAllocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+
+constexpr uint32_t g_salts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+struct ScalarKernel
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static void Set (uint32_t* block, uint32_t key) noexcept
+    {
+        for (size_t ii = 0; ii < g_blockWords; ++ii)
+            block[ii] |= uint32_t (1) << ((key * g_salts[ii]) >> 27);
+    }
+
+    static bool Test (const uint32_t* block, uint32_t key) noexcept
+    {
+        bool res = true;
+        for (size_t ii = 0; ii < g_blockWords; ++ii)
+            res &= (block[ii] >> ((key * g_salts[ii]) >> 27)) & 1;
+        return res;
+    }
+};
+
+struct Avx2Kernel
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx2");
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i Mask (uint32_t key) noexcept
+    {
+        const auto salts = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (g_salts));
+        const auto shifts = _mm256_srli_epi32 (_mm256_mullo_epi32 (_mm256_set1_epi32 (key), salts), 27);
+        return _mm256_sllv_epi32 (_mm256_set1_epi32 (1), shifts);
+    }
+
+    __attribute__((target("avx2")))
+    static void Set (uint32_t* block, uint32_t key) noexcept
+    {
+        auto* p = reinterpret_cast<__m256i*> (block);
+        _mm256_store_si256 (p, _mm256_or_si256 (_mm256_load_si256 (p), Mask (key)));
+    }
+
+    __attribute__((target("avx2")))
+    static bool Test (const uint32_t* block, uint32_t key) noexcept
+    {
+        return _mm256_testc_si256 (_mm256_load_si256 (reinterpret_cast<const __m256i*> (block)), Mask (key));
+    }
+};
+
+class BlockedBloom
+{
+public:
+    // Rounded down to whole blocks, one block at least
+    explicit BlockedBloom (size_t bytes)
+        : m_words (std::max<size_t> (1, bytes / g_blockBytes) * g_blockWords)
+    {
+    }
+
+    template <class Kernel>
+    void Insert (uint64_t key) noexcept
+    {
+        const auto hash = MixHash (key);
+        Kernel::Set (BlockAt (hash), static_cast<uint32_t> (hash));
+    }
+
+    template <class Kernel>
+    bool Contains (uint64_t key) const noexcept
+    {
+        const auto hash = MixHash (key);
+        return Kernel::Test (BlockAt (hash), static_cast<uint32_t> (hash));
+    }
+
+    // Batches hash a group of keys and prefetch all their blocks first, so that the misses
+    // of the group overlap instead of each waiting for the previous one
+    template <class Kernel>
+    void Insert (const uint64_t* keys, size_t size) noexcept
+    {
+        uint64_t hashes[g_group];
+        for (size_t begin = 0; begin < size; begin += g_group)
+        {
+            const auto n = std::min (g_group, size - begin);
+            Prefetch (keys + begin, n, hashes);
+            for (size_t ii = 0; ii < n; ++ii)
+                Kernel::Set (BlockAt (hashes[ii]), static_cast<uint32_t> (hashes[ii]));
+        }
+    }
+
+    // Writes one byte per key, returns how many were found
+    template <class Kernel>
+    size_t Contains (const uint64_t* keys, size_t size, uint8_t* found) const noexcept
+    {
+        size_t res = 0;
+        uint64_t hashes[g_group];
+        for (size_t begin = 0; begin < size; begin += g_group)
+        {
+            const auto n = std::min (g_group, size - begin);
+            Prefetch (keys + begin, n, hashes);
+            for (size_t ii = 0; ii < n; ++ii)
+                res += found[begin + ii] = Kernel::Test (BlockAt (hashes[ii]), static_cast<uint32_t> (hashes[ii]));
+        }
+        return res;
+    }
+
+    size_t Bits() const noexcept
+    {
+        return m_words.size() * 32;
+    }
+
+    template <class Solution>
+    uint64_t Ones() const noexcept
+    {
+        return CountBulk<Solution> (m_words.data(), m_words.size());
+    }
+
+    template <class Solution>
+    double Fill() const noexcept
+    {
+        return static_cast<double> (Ones<Solution>()) / Bits();
+    }
+
+    // Every insert sets 8 of the m bits, each bit with probability 8 / m, so the expected share
+    // of clear bits after n inserts is exp(-8n / m), solved for n (Swamidass and Baldi)
+    template <class Solution>
+    double EstimateCount() const noexcept
+    {
+        const auto fill = Fill<Solution>();
+        return fill < 1 ? -static_cast<double> (Bits()) / 8 * std::log1p (-fill) : INFINITY;
+    }
+
+    bool operator== (const BlockedBloom& other) const noexcept
+    {
+        return m_words == other.m_words;
+    }
+
+private:
+    static constexpr size_t g_group = 16;
+
+    size_t Blocks() const noexcept
+    {
+        return m_words.size() / g_blockWords;
+    }
+
+    // Multiply-shift range reduction of the high hash half
+    size_t BlockIndex (uint64_t hash) const noexcept
+    {
+        return ((hash >> 32) * Blocks()) >> 32;
+    }
+
+    uint32_t* BlockAt (uint64_t hash) noexcept
+    {
+        return m_words.data() + BlockIndex (hash) * g_blockWords;
+    }
+
+    const uint32_t* BlockAt (uint64_t hash) const noexcept
+    {
+        return m_words.data() + BlockIndex (hash) * g_blockWords;
+    }
+
+    void Prefetch (const uint64_t* keys, size_t n, uint64_t* hashes) const noexcept
+    {
+        for (size_t ii = 0; ii < n; ++ii)
+        {
+            hashes[ii] = MixHash (keys[ii]);
+            __builtin_prefetch (BlockAt (hashes[ii]));
+        }
+    }
+
+    std::vector<uint32_t, BlockAllocator<uint32_t>> m_words;
+};
+
+}
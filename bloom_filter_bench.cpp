@@ -0,0 +1,181 @@
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "best_count.h"
+#include "bloom_filter.h"
+
+using bloom::Avx2Kernel;
+using bloom::BlockedBloom;
+using bloom::ScalarKernel;
+
+// Filters are loaded at g_bitsPerKey with the keys [0, n); keys from n on are absent
+
+namespace
+{
+
+constexpr size_t g_bitsPerKey = 10;
+constexpr size_t g_batch = 4096;
+
+size_t Capacity (const BlockedBloom& filter) noexcept
+{
+    return filter.Bits() / g_bitsPerKey;
+}
+
+BlockedBloom Loaded (size_t bytes)
+{
+    BlockedBloom filter (bytes);
+    std::vector<uint64_t> keys (g_batch);
+    for (size_t begin = 0; begin < Capacity (filter); begin += g_batch)
+    {
+        const auto n = std::min (g_batch, Capacity (filter) - begin);
+        std::iota (keys.begin(), keys.begin() + n, begin);
+        filter.Insert<ScalarKernel> (keys.data(), n);
+    }
+    return filter;
+}
+
+// Half present, half absent, in random order
+std::vector<uint64_t> Probes (size_t present, size_t size)
+{
+    std::mt19937_64 gen(42);
+    std::vector<uint64_t> res (size);
+    for (auto& key : res)
+        key = gen() % 2 ? gen() % present : present + gen() % present;
+    return res;
+}
+
+#define BLOOM_SIZES RangeMultiplier (16)->Range (1 << 16, 1 << 28)
+
+}
+
+// Arg: filter bytes
+template <class Kernel>
+void BM_BloomInsert (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    BlockedBloom filter (state.range (0));
+    std::vector<uint64_t> keys (g_batch);
+    uint64_t next = 0;
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        std::iota (keys.begin(), keys.end(), next);
+        next += g_batch;
+        filter.template Insert<Kernel> (keys.data(), keys.size());
+    }
+
+    state.SetItemsProcessed (state.iterations() * g_batch);
+}
+
+BENCHMARK_TEMPLATE(BM_BloomInsert, ScalarKernel)->BLOOM_SIZES;
+BENCHMARK_TEMPLATE(BM_BloomInsert, Avx2Kernel)->BLOOM_SIZES;
+
+// Lookups/s of batched and one-at-a-time queries, with the measured false-positive rate
+template <class Kernel, bool Batched>
+void BM_BloomQuery (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const auto filter = Loaded (state.range (0));
+    const auto probes = Probes (Capacity (filter), g_batch);
+    std::vector<uint8_t> found (g_batch);
+
+    size_t falsePositives = 0;
+    constexpr size_t absent = 1 << 20;
+    for (size_t ii = 0; ii < absent; ++ii)
+        falsePositives += filter.template Contains<Kernel> (Capacity (filter) + ii);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        if constexpr (Batched)
+            benchmark::DoNotOptimize (filter.template Contains<Kernel> (probes.data(), probes.size(), found.data()));
+        else
+            for (auto key : probes)
+                benchmark::DoNotOptimize (filter.template Contains<Kernel> (key));
+    }
+
+    state.SetItemsProcessed (state.iterations() * g_batch);
+    state.counters["fpr"] = static_cast<double> (falsePositives) / absent;
+}
+
+BENCHMARK_TEMPLATE(BM_BloomQuery, ScalarKernel, false)->BLOOM_SIZES;
+BENCHMARK_TEMPLATE(BM_BloomQuery, ScalarKernel, true)->BLOOM_SIZES;
+BENCHMARK_TEMPLATE(BM_BloomQuery, Avx2Kernel, false)->BLOOM_SIZES;
+BENCHMARK_TEMPLATE(BM_BloomQuery, Avx2Kernel, true)->BLOOM_SIZES;
+
+// Cost of the popcount-based cardinality estimate, and its relative error
+template <class Solution>
+void BM_BloomEstimate (benchmark::State &state)
+{
+    const auto filter = Loaded (state.range (0));
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        benchmark::DoNotOptimize (filter.EstimateCount<Solution>());
+    }
+
+    state.SetBytesProcessed (state.iterations() * filter.Bits() / 8);
+    state.counters["fill"] = filter.Fill<Solution>();
+    state.counters["error"] = filter.EstimateCount<Solution>() / Capacity (filter) - 1;
+}
+
+BENCHMARK_TEMPLATE(BM_BloomEstimate, AsmSolution)->BLOOM_SIZES;
+BENCHMARK_TEMPLATE(BM_BloomEstimate, Avx2Solution)->BLOOM_SIZES;
+BENCHMARK_TEMPLATE(BM_BloomEstimate, BestCount)->BLOOM_SIZES;
+
+#undef BLOOM_SIZES
+
+// No false negatives, same bits from every kernel and path, estimate within 2%
+void BM_BloomCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t bytes : {32, 1000, 1 << 20})
+        {
+            const auto keys = Probes (1 << 30, bytes);
+            BlockedBloom scalar (bytes), batched (bytes), simd (bytes);
+            for (auto key : keys)
+                scalar.Insert<ScalarKernel> (key);
+            batched.Insert<ScalarKernel> (keys.data(), keys.size());
+            if (Avx2Kernel::Available())
+                simd.Insert<Avx2Kernel> (keys.data(), keys.size());
+            else
+                simd = scalar;
+
+            std::vector<uint8_t> found (keys.size());
+            if (!(scalar == batched) || !(scalar == simd) ||
+                simd.Contains<ScalarKernel> (keys.data(), keys.size(), found.data()) != keys.size() ||
+                (Avx2Kernel::Available() && simd.Contains<Avx2Kernel> (keys.data(), keys.size(), found.data()) != keys.size()))
+                throw std::runtime_error ("test");
+
+            if (simd.Ones<Avx2Solution>() != simd.Ones<ReferenceSolution>())
+                throw std::runtime_error ("test");
+        }
+
+        const auto filter = Loaded (1 << 20);
+        if (std::fabs (filter.EstimateCount<Avx2Solution>() / Capacity (filter) - 1) > 0.02)
+            throw std::runtime_error ("test");
+    }
+}
+
+BENCHMARK (BM_BloomCheck);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Evicts every cache line of [data, data + bytes) from the whole hierarchy.
+class CacheFlush
+{
+public:
+    static void Range (const void* data, size_t bytes) noexcept
+    {
+        if (!bytes)
+            return;
+
+        static const bool hasClflushopt = DetectClflushopt();
+        if (hasClflushopt)
+            RangeOpt (data, bytes);
+        else
+            RangeLegacy (data, bytes);
+        _mm_mfence();
+    }
+
+private:
+    static constexpr uintptr_t g_line = 64;
+
+    static bool DetectClflushopt() noexcept
+    {
+        unsigned eax, ebx, ecx, edx;
+        return __get_cpuid_count (7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_CLFLUSHOPT);
+    }
+
+    __attribute__((target("clflushopt")))
+    static void RangeOpt (const void* data, size_t bytes) noexcept
+    {
+        const auto begin = reinterpret_cast<uintptr_t> (data) & ~(g_line - 1);
+        const auto end = reinterpret_cast<uintptr_t> (data) + bytes;
+        for (auto line = begin; line < end; line += g_line)
+            _mm_clflushopt (reinterpret_cast<void*> (line));
+    }
+
+    static void RangeLegacy (const void* data, size_t bytes) noexcept
+    {
+        const auto begin = reinterpret_cast<uintptr_t> (data) & ~(g_line - 1);
+        const auto end = reinterpret_cast<uintptr_t> (data) + bytes;
+        for (auto line = begin; line < end; line += g_line)
+            _mm_clflush (reinterpret_cast<void*> (line));
+    }
+};
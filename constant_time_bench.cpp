@@ -0,0 +1,203 @@
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "count_bits.h"
+#include "reverse_int.h"
+
+// Timing-leak detection after dudect: calls are timed on a fixed input and on random ones,
+// picking the class at random per measurement so drift hits both alike, and Welch's t-test
+// tells whether the two timing distributions differ. |t| above g_leakThreshold means leak.
+
+namespace
+{
+
+constexpr double g_leakThreshold = 10;
+constexpr size_t g_measurements = 1 << 14;
+// Calls per measurement, amortizing rdtsc resolution
+constexpr size_t g_batch = 16;
+
+template <class Solution>
+struct PopCountKernel
+{
+    static auto Run (uint32_t v) noexcept
+    {
+        return Solution::Count (v);
+    }
+};
+
+template <class Solution>
+struct ReverseKernel
+{
+    static auto Run (uint32_t v) noexcept
+    {
+        return Solution::reverse (static_cast<int> (v));
+    }
+};
+
+// Running mean and variance of one input class (Welford)
+struct Moments
+{
+    double n = 0;
+    double mean = 0;
+    double m2 = 0;
+
+    void Push (double x) noexcept
+    {
+        n += 1;
+        const auto delta = x - mean;
+        mean += delta / n;
+        m2 += delta * (x - mean);
+    }
+
+    double Variance() const noexcept
+    {
+        return n > 1 ? m2 / (n - 1) : 0;
+    }
+};
+
+double WelchT (const Moments& a, const Moments& b) noexcept
+{
+    const auto den = std::sqrt (a.Variance() / a.n + b.Variance() / b.n);
+    return den > 0 ? (a.mean - b.mean) / den : 0;
+}
+
+class TimingLeak
+{
+public:
+    // One round of g_measurements; returns the kernel calls made
+    template <class Kernel>
+    size_t Round()
+    {
+        std::bernoulli_distribution coin(0.5);
+        std::uniform_int_distribution<uint32_t> dist;
+        for (size_t ii = 0; ii < g_measurements; ++ii)
+        {
+            m_classes[ii] = coin(m_gen);
+            for (size_t jj = 0; jj < g_batch; ++jj)
+                m_inputs[ii * g_batch + jj] = m_classes[ii] ? dist(m_gen) : 0;
+        }
+
+        for (size_t ii = 0; ii < g_measurements; ++ii)
+        {
+            const auto* in = &m_inputs[ii * g_batch];
+            _mm_lfence();
+            const auto start = __rdtsc();
+            _mm_lfence();
+            for (size_t jj = 0; jj < g_batch; ++jj)
+                benchmark::DoNotOptimize (Kernel::Run (in[jj]));
+            _mm_lfence();
+            m_cycles[ii] = __rdtsc() - start;
+        }
+
+        // Interrupts and migrations only ever add time, crop the slowest tenth
+        m_sorted = m_cycles;
+        const auto crop = m_sorted.begin() + m_sorted.size() * 9 / 10;
+        std::nth_element (m_sorted.begin(), crop, m_sorted.end());
+        for (size_t ii = 0; ii < g_measurements; ++ii)
+            if (m_cycles[ii] <= *crop)
+                m_moments[m_classes[ii]].Push (static_cast<double> (m_cycles[ii]));
+
+        return g_measurements * g_batch;
+    }
+
+    double T() const noexcept
+    {
+        return WelchT (m_moments[0], m_moments[1]);
+    }
+
+    double Cycles (int cls) const noexcept
+    {
+        return m_moments[cls].mean / g_batch;
+    }
+
+private:
+    std::mt19937 m_gen {42};
+    std::vector<uint32_t> m_inputs = std::vector<uint32_t> (g_measurements * g_batch);
+    std::vector<uint8_t> m_classes = std::vector<uint8_t> (g_measurements);
+    std::vector<uint64_t> m_cycles = std::vector<uint64_t> (g_measurements);
+    std::vector<uint64_t> m_sorted;
+    Moments m_moments[2];
+};
+
+}
+
+template <class Kernel>
+void BM_TimingLeak (benchmark::State &state)
+{
+    TimingLeak leak;
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        state.SetItemsProcessed (state.items_processed() + leak.template Round<Kernel>());
+    }
+
+    state.counters["t"] = std::fabs (leak.T());
+    state.counters["fixed_cycles"] = leak.Cycles (0);
+    state.counters["random_cycles"] = leak.Cycles (1);
+}
+
+// GCC recognizes the clear-lowest-bit loop of ReferenceSolution and emits popcnt for it
+BENCHMARK_TEMPLATE(BM_TimingLeak, PopCountKernel<ReferenceSolution>);
+BENCHMARK_TEMPLATE(BM_TimingLeak, PopCountKernel<MagicSolution>);
+BENCHMARK_TEMPLATE(BM_TimingLeak, PopCountKernel<ConstantTimeSolution>);
+BENCHMARK_TEMPLATE(BM_TimingLeak, ReverseKernel<reverse_int::ReferenceSolution>);
+BENCHMARK_TEMPLATE(BM_TimingLeak, ReverseKernel<reverse_int::MySolution>);
+BENCHMARK_TEMPLATE(BM_TimingLeak, ReverseKernel<reverse_int::ConstantTimeSolution>);
+
+// Fails when a constant-time kernel shows a leak, or when the early-exit reverse does not,
+// which would mean the test lost its power
+template <class Kernel>
+void BM_ConstantTimeCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        TimingLeak leak, leaky;
+        for (int ii = 0; ii < 8; ++ii)
+        {
+            leak.Round<Kernel>();
+            leaky.Round<ReverseKernel<reverse_int::ReferenceSolution>>();
+        }
+
+        state.counters["t"] = std::fabs (leak.T());
+        state.counters["leaky_t"] = std::fabs (leaky.T());
+        if (std::fabs (leak.T()) > g_leakThreshold)
+            state.SkipWithError ("timing depends on input");
+        else if (std::fabs (leaky.T()) <= g_leakThreshold)
+            state.SkipWithError ("reference leak not detected");
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_ConstantTimeCheck, PopCountKernel<ConstantTimeSolution>)->Iterations (1);
+BENCHMARK_TEMPLATE(BM_ConstantTimeCheck, ReverseKernel<reverse_int::ConstantTimeSolution>)->Iterations (1);
+
+void BM_ConstantTimeReverseCheck (benchmark::State &state)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
+    std::vector<int> nums = {0, 1, -1, 10, -10, INT_MAX, INT_MIN, 1463847412, -1463847412, 1463847413, -1463847413, 1000000003};
+    for (size_t ii = 0; ii < 100000; ++ii)
+        nums.push_back (dist(gen));
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (auto num : nums)
+            if (reverse_int::ConstantTimeSolution::reverse (num) != reverse_int::ReferenceSolution::reverse (num))
+                throw std::runtime_error ("test");
+
+        state.SetItemsProcessed (state.items_processed() + nums.size());
+    }
+}
+
+BENCHMARK (BM_ConstantTimeReverseCheck);
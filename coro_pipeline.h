@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Minimal building blocks for the C++20 pipeline benchmark: a thread pool coroutines hop
+// onto with `co_await pool.Schedule()`, and an eagerly started Task awaited for its result.
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool (size_t threads)
+    {
+        for (size_t ii = 0; ii < threads; ++ii)
+            m_threads.emplace_back ([this]() { Run(); });
+    }
+
+    ThreadPool (const ThreadPool&) = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock (m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    auto Schedule() noexcept
+    {
+        struct Awaiter
+        {
+            ThreadPool& pool;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend (std::coroutine_handle<> handle) { pool.Post (handle); }
+            void await_resume() const noexcept {}
+        };
+
+        return Awaiter {*this};
+    }
+
+private:
+    void Post (std::coroutine_handle<> handle)
+    {
+        {
+            std::lock_guard<std::mutex> lock (m_mutex);
+            m_queue.push_back (handle);
+        }
+        m_wake.notify_one();
+    }
+
+    void Run()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock (m_mutex);
+            m_wake.wait (lock, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+
+            const auto handle = m_queue.front();
+            m_queue.pop_front();
+            lock.unlock();
+            handle.resume();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::coroutine_handle<>> m_queue;
+    bool m_stop = false;
+    std::vector<std::thread> m_threads;
+};
+
+// Fire-and-forget coroutine, its frame is freed when it finishes
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Starts running as soon as it is called. Await it from a coroutine or Get() it from a thread;
+// the frame lives until the Task is destroyed, which must not happen before it completes.
+template <class T>
+class Task
+{
+public:
+    struct promise_type
+    {
+        std::optional<T> value;
+        // nullptr while running, the awaiting coroutine once one suspends on it, Done() at the end
+        std::atomic<void*> state {nullptr};
+
+        void* Done() noexcept { return this; }
+
+        Task get_return_object() noexcept { return Task (std::coroutine_handle<promise_type>::from_promise (*this)); }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        void return_value (T v) { value.emplace (std::move (v)); }
+        void unhandled_exception() { std::terminate(); }
+
+        auto final_suspend() noexcept
+        {
+            struct Awaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend (std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    auto& promise = handle.promise();
+                    void* waiter = promise.state.exchange (promise.Done(), std::memory_order_acq_rel);
+                    return waiter ? std::coroutine_handle<>::from_address (waiter) : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            return Awaiter {};
+        }
+    };
+
+    Task (Task&& other) noexcept
+        : m_handle (std::exchange (other.m_handle, nullptr))
+    {
+    }
+
+    Task& operator= (Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange (other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    auto operator co_await() & noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept
+            {
+                return handle.promise().state.load (std::memory_order_acquire) == handle.promise().Done();
+            }
+
+            bool await_suspend (std::coroutine_handle<> waiter) noexcept
+            {
+                void* expected = nullptr;
+                // Fails only when the task finished in the meantime, then the waiter goes on right away
+                return handle.promise().state.compare_exchange_strong (expected, waiter.address(), std::memory_order_acq_rel);
+            }
+
+            T await_resume()
+            {
+                return std::move (*handle.promise().value);
+            }
+        };
+
+        return Awaiter {m_handle};
+    }
+
+    // Blocks the calling thread until the result is ready
+    T Get()
+    {
+        std::promise<T> result;
+        auto future = result.get_future();
+        // The promise is moved into the frame of the helper, which outlives set_value
+        [](Task& task, std::promise<T> result) -> Detached
+            {
+                result.set_value (co_await task);
+            } (*this, std::move (result));
+        return future.get();
+    }
+
+private:
+    explicit Task (std::coroutine_handle<promise_type> handle) noexcept
+        : m_handle (handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
@@ -0,0 +1,197 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "coro_pipeline.h"
+#include "count_bits.h"
+
+// Popcount over a file: a synchronous read-then-count loop against a coroutine pipeline
+// where an I/O pool reads ahead while a compute pool counts and the driver reduces.
+
+namespace
+{
+
+constexpr size_t g_fileBytes = 512ull << 20;
+
+// Generated once per process and removed at exit
+class NumbersFile
+{
+public:
+    static const NumbersFile& Instance()
+    {
+        static const NumbersFile file;
+        return file;
+    }
+
+    const std::string& Path() const noexcept
+    {
+        return m_path;
+    }
+
+    uint64_t Expected() const noexcept
+    {
+        return m_expected;
+    }
+
+private:
+    NumbersFile()
+    {
+        const char* dir = std::getenv ("TMPDIR");
+        m_path = std::string (dir ? dir : "/tmp") + "/coro_pipeline_bench." + std::to_string (getpid());
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
+
+        const int fd = open (m_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+        std::vector<uint32_t> block ((4 << 20) / sizeof (uint32_t));
+        for (size_t written = 0; fd >= 0 && written < g_fileBytes; written += block.size() * sizeof (uint32_t))
+        {
+            for (auto& v : block)
+                v = dist(gen);
+            m_expected += CountBulk<AsmSolution> (block.data(), block.size());
+            if (write (fd, block.data(), block.size() * sizeof (uint32_t)) < 0)
+                break;
+        }
+
+        if (fd >= 0)
+        {
+            fsync (fd);
+            close (fd);
+        }
+    }
+
+    ~NumbersFile()
+    {
+        unlink (m_path.c_str());
+    }
+
+    std::string m_path;
+    uint64_t m_expected = 0;
+};
+
+// Drops the file from the page cache so that every pass really reads it
+int OpenCold (const std::string& path)
+{
+    const int fd = open (path.c_str(), O_RDONLY);
+    if (fd >= 0)
+        posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+    return fd;
+}
+
+template <class Solution>
+uint64_t CountFileSync (int fd, std::vector<uint32_t>& buffer)
+{
+    uint64_t res = 0;
+    for (off_t offset = 0;;)
+    {
+        const auto bytes = pread (fd, buffer.data(), buffer.size() * sizeof (uint32_t), offset);
+        if (bytes <= 0)
+            return res;
+        offset += bytes;
+        res += CountBulk<Solution> (buffer.data(), bytes / sizeof (uint32_t));
+    }
+}
+
+template <class Solution>
+Task<uint64_t> CountChunk (ThreadPool& io, ThreadPool& compute, int fd, off_t offset, std::vector<uint32_t>& buffer)
+{
+    co_await io.Schedule();
+    const auto bytes = pread (fd, buffer.data(), buffer.size() * sizeof (uint32_t), offset);
+
+    co_await compute.Schedule();
+    co_return bytes > 0 ? CountBulk<Solution> (buffer.data(), bytes / sizeof (uint32_t)) : 0;
+}
+
+// Keeps up to buffers.size() chunks in flight and reduces them in file order,
+// so a buffer is reused only once the chunk that owned it has been summed
+template <class Solution>
+Task<uint64_t> CountFilePipelined (ThreadPool& io, ThreadPool& compute, int fd, off_t size, std::vector<std::vector<uint32_t>>& buffers)
+{
+    const off_t chunkBytes = buffers.front().size() * sizeof (uint32_t);
+
+    uint64_t res = 0;
+    std::deque<Task<uint64_t>> inflight;
+    size_t slot = 0;
+    for (off_t offset = 0; offset < size; offset += chunkBytes)
+    {
+        if (inflight.size() == buffers.size())
+        {
+            res += co_await inflight.front();
+            inflight.pop_front();
+        }
+        inflight.push_back (CountChunk<Solution> (io, compute, fd, offset, buffers[slot++ % buffers.size()]));
+    }
+
+    while (!inflight.empty())
+    {
+        res += co_await inflight.front();
+        inflight.pop_front();
+    }
+
+    co_return res;
+}
+
+}
+
+template <class Solution>
+void BM_CountFileSync (benchmark::State &state)
+{
+    const auto& file = NumbersFile::Instance();
+    std::vector<uint32_t> buffer (state.range (0) / sizeof (uint32_t));
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        state.PauseTiming();
+        const int fd = OpenCold (file.Path());
+        state.ResumeTiming();
+
+        if (CountFileSync<Solution> (fd, buffer) != file.Expected())
+            state.SkipWithError ("wrong count");
+        close (fd);
+    }
+
+    state.SetBytesProcessed (state.iterations() * g_fileBytes);
+}
+
+// Args: chunk bytes, compute threads; the depth of read-ahead is twice the compute threads
+template <class Solution>
+void BM_CountFileCoro (benchmark::State &state)
+{
+    const auto& file = NumbersFile::Instance();
+    const size_t computeThreads = state.range (1);
+
+    ThreadPool io (2);
+    ThreadPool compute (computeThreads);
+    std::vector<std::vector<uint32_t>> buffers (2 * computeThreads, std::vector<uint32_t> (state.range (0) / sizeof (uint32_t)));
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        state.PauseTiming();
+        const int fd = OpenCold (file.Path());
+        state.ResumeTiming();
+
+        if (CountFilePipelined<Solution> (io, compute, fd, g_fileBytes, buffers).Get() != file.Expected())
+            state.SkipWithError ("wrong count");
+        close (fd);
+    }
+
+    state.SetBytesProcessed (state.iterations() * g_fileBytes);
+}
+
+BENCHMARK_TEMPLATE(BM_CountFileSync, AsmSolution)->UseRealTime()->RangeMultiplier (16)->Range (64 << 10, 4 << 20);
+BENCHMARK_TEMPLATE(BM_CountFileSync, ByteTableSolution)->UseRealTime()->RangeMultiplier (16)->Range (64 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(BM_CountFileCoro, AsmSolution)->UseRealTime()->ArgsProduct ({{64 << 10, 1 << 20, 4 << 20}, {1, 2, 4}});
+BENCHMARK_TEMPLATE(BM_CountFileCoro, ByteTableSolution)->UseRealTime()->ArgsProduct ({{64 << 10, 1 << 20, 4 << 20}, {1, 2, 4}});
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+
+#include <boost/make_unique.hpp>
+
+struct ReferenceSolution
+{
+    __attribute__((always_inline))
+    static constexpr uint32_t Count (uint32_t n) noexcept
+    {
+        uint32_t i = 0;
+
+        while (n)
+        {
+            n &= n - 1;
+            ++i;
+        }
+
+        return i;
+    }
+};
+
+// One popcnt instruction where the includer is built with -mpopcnt, as the kernels target
+// sets for everything linking it; a libgcc call otherwise
+struct AsmSolution
+{
+    __attribute__((always_inline))
+    static constexpr uint32_t Count (uint32_t n) noexcept
+    {
+        return __builtin_popcount (n);
+    }
+};
+
+struct MagicSolution
+{
+    __attribute__((always_inline))
+    static constexpr uint32_t Count (uint32_t v) noexcept
+    {
+        v = v - ((v >> 1) & 0x55555555);
+        v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+        return static_cast<uint16_t> ((((v + (v >> 4)) & 0xf0f0f0f) * 0x1010101) >> 24);
+    }
+};
+
+// No branch, no memory access: popcnt latency does not depend on its operand. Spelled out
+// in asm since __builtin_popcount may be lowered to a libgcc table lookup.
+struct ConstantTimeSolution
+{
+    __attribute__((always_inline))
+    static uint32_t Count (uint32_t n) noexcept
+    {
+        uint32_t res;
+        asm ("popcnt %1, %0" : "=r" (res) : "r" (n));
+        return res;
+    }
+};
+
+template <size_t TableSize>
+constexpr static auto CountTable() noexcept
+{
+    std::array<uint32_t, TableSize> res = {0,};
+    for (size_t ii = 0; ii < res.size(); ++ii)
+        res[ii] = ReferenceSolution::Count (ii);
+    return res;
+}
+
+struct ByteTableSolution
+{
+    static constexpr uint32_t Count (uint32_t n) noexcept
+    {
+        uint32_t res = 0;
+
+        res += g_byteTable[n & 0xFF];
+        res += g_byteTable[(n >>= 8) & 0xFF];
+        res += g_byteTable[(n >>= 8) & 0xFF];
+        res += g_byteTable[(n >> 8) & 0xFF];
+
+        return res;
+    }
+
+    static const auto& Table() noexcept
+    {
+        return g_byteTable;
+    }
+
+private:
+    constexpr static auto g_byteTable = CountTable<256>();
+};
+
+struct ElevenBitsTableSolution
+{
+    static constexpr uint32_t Count (uint32_t n) noexcept
+    {
+        uint32_t res = 0;
+
+        res += g_byteTable[n & 0b11111111111];
+        res += g_byteTable[(n >>= 11) & 0b11111111111];
+        res += g_byteTable[(n >> 11)];
+
+        return res;
+    }
+
+    static const auto& Table() noexcept
+    {
+        return g_byteTable;
+    }
+
+private:
+    inline const static auto g_byteTable = CountTable<2048>();
+};
+
+struct WordsTableSolution
+{
+    static constexpr uint32_t Count (uint32_t n) noexcept
+    {
+        return g_byteTable[n & 0xFFFF] +
+            g_byteTable[n >> 16];
+    }
+
+    static const auto& Table() noexcept
+    {
+        return g_byteTable;
+    }
+
+private:
+    inline const static auto g_byteTable = CountTable<65536>();
+};
+
+struct FullTableSolution
+{
+private:
+    static auto CountFullTable() 
+    {
+        auto table = boost::make_unique_noinit<uint32_t[]> (1ull << 32);
+
+        std::array<std::future<void>, 4> workers;
+        const auto batch = (1ull << 32)/workers.size();
+        for (size_t ii = 0; ii < workers.size(); ++ii)
+            workers[ii] = std::async (std::launch::async, [&table, start = ii*batch, finish = (ii + 1)*batch]()
+                {
+                    for (auto ii = start; ii < finish; ++ii)
+                        table[ii] = ElevenBitsTableSolution::Count (ii);
+                });
+
+        return table;
+    }
+
+    static auto& GetTable()
+    {
+        static const auto table = CountFullTable();
+        return table;
+    }
+
+public:
+    static uint32_t Count (uint32_t n) noexcept
+    {
+        return GetTable()[n];
+    }
+
+    // The one table entry Count (n) reads; the whole table is too large to evict
+    static const uint32_t* Entry (uint32_t n) noexcept
+    {
+        return &GetTable()[n];
+    }
+};
+
+template <class Solution>
+uint64_t CountBulk (const uint32_t* data, size_t size) noexcept
+{
+    uint64_t res = 0;
+    for (size_t ii = 0; ii < size; ++ii)
+        res += Solution::Count (data[ii]);
+    return res;
+}
@@ -0,0 +1,164 @@
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "best_count.h"
+
+// Runs every candidate over every size class and bit density, then writes the per-class
+// winners as best_count_config.h
+
+namespace
+{
+
+constexpr const auto& g_candidates = g_bestCountCandidateNames;
+
+// ReferenceSolution is sensitive to the share of set bits: 1/8, 1/2 and 7/8
+constexpr const char* g_densities[] = {"sparse", "half", "dense"};
+
+std::vector<uint32_t> GenerateBits (size_t size, size_t density)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
+
+    std::vector<uint32_t> res (size);
+    for (auto& v : res)
+    {
+        const auto a = dist(gen), b = dist(gen), c = dist(gen);
+        v = density == 0 ? a & b & c : density == 1 ? a : a | b | c;
+    }
+
+    return res;
+}
+
+struct Cell
+{
+    size_t candidate;
+    size_t sizeClass;
+};
+
+using Scores = std::array<std::array<double, std::size (g_candidates)>, std::size (g_bestCountSizeClasses)>;
+
+template <class Solution>
+void Register (size_t candidate, std::map<std::string, Cell>& cells)
+{
+    for (size_t sizeClass = 0; sizeClass < std::size (g_bestCountSizeClasses); ++sizeClass)
+        for (size_t density = 0; density < std::size (g_densities); ++density)
+        {
+            const auto size = g_bestCountSizeClasses[sizeClass];
+            const auto name = std::string (g_candidates[candidate]) + "/" + std::to_string (size) + "/" + g_densities[density];
+            cells[name] = {candidate, sizeClass};
+
+            benchmark::RegisterBenchmark (name.c_str(), [size, density](benchmark::State &state)
+                {
+                    const auto nums = GenerateBits (size, density);
+                    Solution::Count (42); // Heatup table
+
+                    for (auto _ : state)
+                    {
+                        boost::ignore_unused (_);
+                        benchmark::DoNotOptimize (CountBulk<Solution> (nums.data(), nums.size()));
+                        state.SetItemsProcessed (state.items_processed() + nums.size());
+                    }
+                });
+        }
+}
+
+// Accumulates ns per element over densities for every (size class, candidate)
+class TuneReporter : public benchmark::ConsoleReporter
+{
+public:
+    explicit TuneReporter (const std::map<std::string, Cell>& cells)
+        : m_cells (cells)
+    {
+        for (auto& row : m_scores)
+            row.fill (0);
+    }
+
+    void ReportRuns (const std::vector<Run>& reports) override
+    {
+        ConsoleReporter::ReportRuns (reports);
+
+        for (const auto& run : reports)
+        {
+            const auto cell = m_cells.find (run.run_name.function_name);
+            if (cell == m_cells.end() || run.run_type != Run::RT_Iteration)
+                continue;
+
+            const auto size = g_bestCountSizeClasses[cell->second.sizeClass];
+            m_scores[cell->second.sizeClass][cell->second.candidate] += run.GetAdjustedCPUTime() / size;
+        }
+    }
+
+    const Scores& GetScores() const noexcept
+    {
+        return m_scores;
+    }
+
+private:
+    const std::map<std::string, Cell>& m_cells;
+    Scores m_scores;
+};
+
+bool WriteConfig (const std::string& path, const Scores& scores)
+{
+    std::ofstream out (path);
+    out << "// Generated by count_bits_autotune, rebuild the autotune target to refresh\n"
+        << "#pragma once\n\n"
+        << "#include <tuple>\n\n";
+
+    std::string kernels;
+    for (size_t sizeClass = 0; sizeClass < scores.size(); ++sizeClass)
+    {
+        const auto& row = scores[sizeClass];
+        size_t best = 0;
+        for (size_t candidate = 1; candidate < row.size(); ++candidate)
+            if (row[candidate] > 0 && (row[best] <= 0 || row[candidate] < row[best]))
+                best = candidate;
+
+        out << "// size class " << sizeClass << " (up to " << g_bestCountSizeClasses[sizeClass] << " elements): "
+            << g_candidates[best] << ", " << row[best] / std::size (g_densities) << " ns per element\n";
+        kernels += std::string (sizeClass ? ", " : "") + g_candidates[best];
+    }
+
+    out << "\nconstexpr bool g_bestCountTuned = true;\n"
+        << "\nusing BestCountKernels = std::tuple<" << kernels << ">;\n";
+    return static_cast<bool> (out);
+}
+
+}
+
+int main (int argc, char** argv)
+{
+    benchmark::Initialize (&argc, argv);
+    if (argc != 2)
+    {
+        std::cerr << "usage: " << argv[0] << " [--benchmark_...] <best_count_config.h>\n";
+        return 1;
+    }
+
+    std::map<std::string, Cell> cells;
+    size_t candidate = 0;
+#define REGISTER(Solution) Register<Solution> (candidate++, cells);
+    BEST_COUNT_CANDIDATES(REGISTER)
+#undef REGISTER
+
+    TuneReporter reporter (cells);
+    benchmark::RunSpecifiedBenchmarks (&reporter);
+
+    if (!WriteConfig (argv[1], reporter.GetScores()))
+    {
+        std::cerr << "cannot write " << argv[1] << "\n";
+        return 1;
+    }
+
+    return 0;
+}
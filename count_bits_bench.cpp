@@ -1,144 +1,316 @@
+#include <x86intrin.h>
+
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <random>
 #include <limits>
-#include <future>
+#include <type_traits>
+#include <chrono>
 #include <iostream>
+#include <string>
 
-#include <boost/make_unique.hpp>
 #include <boost/core/ignore_unused.hpp>
 
 #include <benchmark/benchmark.h>
 
-struct ReferenceSolution
+#include "antagonist.h"
+#include "best_count.h"
+#include "cache_flush.h"
+#include "count_bits.h"
+#include "count_bits_avx2.h"
+#include "kernel_stats.h"
+#include "rapl_counter.h"
+
+auto GenerateNumbers()
 {
-    __attribute__((always_inline))
-    static constexpr uint32_t Count (uint32_t n) noexcept
-    {
-        uint32_t i = 0;
+    std::array<uint32_t, 100000> res;
 
-        while (n)
-        {
-            n &= n - 1;
-            ++i;
-        }
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
 
-        return i;
-    }
-};
+    const auto generator = [&gen, &dist]() { return dist(gen); };
 
-#pragma GCC target("popcnt") 
-struct AsmSolution
-{
-    __attribute__((always_inline))
-    static constexpr uint32_t Count (uint32_t n) noexcept
-    {
-        return __builtin_popcount (n);
-    }
-};
+    std::generate (res.begin(), res.end(), generator);
+
+    return res;
+}
 
-struct MagicSolution
+// Counts every number once per iteration until state is done
+template <class Solution, class Numbers>
+void CountLoop (benchmark::State &state, const Numbers& nums)
 {
-    __attribute__((always_inline))
-    static constexpr uint32_t Count (uint32_t v) noexcept
+    for (auto _ : state)
     {
-        v = v - ((v >> 1) & 0x55555555);
-        v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
-        return static_cast<uint16_t> ((((v + (v >> 4)) & 0xf0f0f0f) * 0x1010101) >> 24);
+        boost::ignore_unused (_);
+        for (auto num : nums)
+            benchmark::DoNotOptimize (Solution::Count (num));
+        state.SetItemsProcessed (state.items_processed() + nums.size());
     }
-};
+}
 
-template <size_t TableSize>
-constexpr static auto CountTable() noexcept
+template <class Solution>
+void BM_Count (benchmark::State &state)
 {
-    std::array<uint32_t, TableSize> res = {0,};
-    for (size_t ii = 0; ii < res.size(); ++ii)
-        res[ii] = ReferenceSolution::Count (ii);
-    return res;
+    const auto nums = GenerateNumbers();
+    Solution::Count (42); // Heatup table
+
+    CountLoop<Solution> (state, nums);
 }
 
-struct ByteTableSolution
-{
-    static constexpr uint32_t Count (uint32_t n) noexcept
-    {
-        uint32_t res = 0;
+BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution);
+BENCHMARK_TEMPLATE(BM_Count, AsmSolution);
+BENCHMARK_TEMPLATE(BM_Count, MagicSolution);
+BENCHMARK_TEMPLATE(BM_Count, ConstantTimeSolution);
+BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution);
+BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution);
+BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution);
+BENCHMARK_TEMPLATE(BM_Count, FullTableSolution);
 
-        res += g_byteTable[n & 0xFF];
-        res += g_byteTable[(n >>= 8) & 0xFF];
-        res += g_byteTable[(n >>= 8) & 0xFF];
-        res += g_byteTable[(n >> 8) & 0xFF];
+BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution)->Threads (2);
+BENCHMARK_TEMPLATE(BM_Count, AsmSolution)->Threads (2);
+BENCHMARK_TEMPLATE(BM_Count, MagicSolution)->Threads (2);
+BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution)->Threads (2);
+BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution)->Threads (2);
+BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution)->Threads (2);
+BENCHMARK_TEMPLATE(BM_Count, FullTableSolution)->Threads (2);
 
-        return res;
-    }
+BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution)->Threads (4);
+BENCHMARK_TEMPLATE(BM_Count, AsmSolution)->Threads (4);
+BENCHMARK_TEMPLATE(BM_Count, MagicSolution)->Threads (4);
+BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution)->Threads (4);
+BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution)->Threads (4);
+BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution)->Threads (4);
+BENCHMARK_TEMPLATE(BM_Count, FullTableSolution)->Threads (4);
+
+BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution)->Threads (8);
+BENCHMARK_TEMPLATE(BM_Count, AsmSolution)->Threads (8);
+BENCHMARK_TEMPLATE(BM_Count, MagicSolution)->Threads (8);
+BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution)->Threads (8);
+BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution)->Threads (8);
+BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution)->Threads (8);
+BENCHMARK_TEMPLATE(BM_Count, FullTableSolution)->Threads (8);
 
-private:
-    constexpr static auto g_byteTable = CountTable<256>();
-};
+// Same kernels accounted through kernel_stats, to price the instrumentation
+BENCHMARK_TEMPLATE(BM_Count, kernel_stats::Instrumented<AsmSolution>);
+BENCHMARK_TEMPLATE(BM_Count, kernel_stats::Instrumented<MagicSolution>);
+BENCHMARK_TEMPLATE(BM_Count, kernel_stats::Instrumented<ByteTableSolution>);
+BENCHMARK_TEMPLATE(BM_Count, kernel_stats::Instrumented<WordsTableSolution>);
+BENCHMARK_TEMPLATE(BM_Count, kernel_stats::Instrumented<AsmSolution>)->Threads (4);
+BENCHMARK_TEMPLATE(BM_Count, kernel_stats::Instrumented<MagicSolution>)->Threads (4);
 
-struct ElevenBitsTableSolution
+template <class Solution>
+void BM_CountEnergy (benchmark::State &state)
 {
-    static constexpr uint32_t Count (uint32_t n) noexcept
+    RaplCounter rapl;
+    if (!rapl.Available())
     {
-        uint32_t res = 0;
+        state.SkipWithError ("powercap RAPL is unavailable");
+        return;
+    }
 
-        res += g_byteTable[n & 0b11111111111];
-        res += g_byteTable[(n >>= 11) & 0b11111111111];
-        res += g_byteTable[(n >> 11)];
+    const auto nums = GenerateNumbers();
+    Solution::Count (42); // Heatup table
 
-        return res;
-    }
+    rapl.Start();
+    CountLoop<Solution> (state, nums);
+    SetEnergyCounters (state, rapl);
+}
 
-private:
-    inline const static auto g_byteTable = CountTable<2048>();
-};
+BENCHMARK_TEMPLATE(BM_CountEnergy, ReferenceSolution);
+BENCHMARK_TEMPLATE(BM_CountEnergy, AsmSolution);
+BENCHMARK_TEMPLATE(BM_CountEnergy, MagicSolution);
+BENCHMARK_TEMPLATE(BM_CountEnergy, ByteTableSolution);
+BENCHMARK_TEMPLATE(BM_CountEnergy, ElevenBitsTableSolution);
+BENCHMARK_TEMPLATE(BM_CountEnergy, WordsTableSolution);
+BENCHMARK_TEMPLATE(BM_CountEnergy, FullTableSolution);
 
-struct WordsTableSolution
+// Runs Solution with an Antagonist on the SMT sibling; slowdown is relative to the same core left idle
+template <class Solution>
+void BM_CountNeighbor (benchmark::State &state)
 {
-    static constexpr uint32_t Count (uint32_t n) noexcept
+    Antagonist antagonist;
+    if (!antagonist.Available())
     {
-        return g_byteTable[n & 0xFFFF] +
-            g_byteTable[n >> 16];
+        state.SkipWithError ("no SMT sibling for the current cpu");
+        return;
     }
 
-private:
-    inline const static auto g_byteTable = CountTable<65536>();
-};
+    const auto nums = GenerateNumbers();
+    Solution::Count (42); // Heatup table
 
-struct FullTableSolution
-{
-private:
-    static auto CountFullTable() 
+    const auto pass = [&nums]()
     {
-        auto table = boost::make_unique_noinit<uint32_t[]> (1ull << 32);
+        const auto start = std::chrono::steady_clock::now();
+        for (auto num : nums)
+            benchmark::DoNotOptimize (Solution::Count (num));
+        return std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    };
 
-        std::array<std::future<void>, 4> workers;
-        const auto batch = (1ull << 32)/workers.size();
-        for (size_t ii = 0; ii < workers.size(); ++ii)
-            workers[ii] = std::async (std::launch::async, [&table, start = ii*batch, finish = (ii + 1)*batch]()
-                {
-                    for (auto ii = start; ii < finish; ++ii)
-                        table[ii] = ElevenBitsTableSolution::Count (ii);
-                });
+    const constexpr size_t isolatedPasses = 200;
+    double isolated = 0;
+    for (size_t ii = 0; ii < isolatedPasses; ++ii)
+        isolated += pass();
 
-        return table;
-    }
+    antagonist.Start (state.range (0));
+    state.SetLabel (Antagonist::Name (state.range (0)));
 
-    static auto& GetTable()
+    double contended = 0;
+    for (auto _ : state)
     {
-        static const auto table = CountFullTable();
-        return table;
+        boost::ignore_unused (_);
+        contended += pass();
+        state.SetItemsProcessed (state.items_processed() + nums.size());
     }
 
-public:
-    static uint32_t Count (uint32_t n) noexcept
+    state.counters["slowdown"] = contended / state.iterations() / (isolated / isolatedPasses);
+}
+
+BENCHMARK_TEMPLATE(BM_CountNeighbor, AsmSolution)->DenseRange (0, Antagonist::KindCount - 1);
+BENCHMARK_TEMPLATE(BM_CountNeighbor, MagicSolution)->DenseRange (0, Antagonist::KindCount - 1);
+BENCHMARK_TEMPLATE(BM_CountNeighbor, ByteTableSolution)->DenseRange (0, Antagonist::KindCount - 1);
+BENCHMARK_TEMPLATE(BM_CountNeighbor, ElevenBitsTableSolution)->DenseRange (0, Antagonist::KindCount - 1);
+BENCHMARK_TEMPLATE(BM_CountNeighbor, WordsTableSolution)->DenseRange (0, Antagonist::KindCount - 1);
+BENCHMARK_TEMPLATE(BM_CountNeighbor, FullTableSolution)->DenseRange (0, Antagonist::KindCount - 1);
+
+template <class Solution, class = void>
+struct HasTable : std::false_type {};
+
+template <class Solution>
+struct HasTable<Solution, std::void_t<decltype (Solution::Table())>> : std::true_type {};
+
+template <class Solution, class = void>
+struct HasEntry : std::false_type {};
+
+template <class Solution>
+struct HasEntry<Solution, std::void_t<decltype (Solution::Entry (0))>> : std::true_type {};
+
+// rdtsc fenced so that it waits for the loads before it and runs ahead of none after it
+uint64_t FencedTicks() noexcept
+{
+    _mm_lfence();
+    const auto res = __rdtsc();
+    _mm_lfence();
+    return res;
+}
+
+// Cost of an empty pair of FencedTicks, taken off every timed call
+uint64_t TicksOverhead() noexcept
+{
+    static const uint64_t overhead = []()
+        {
+            std::vector<uint64_t> samples (1001);
+            for (auto& sample : samples)
+            {
+                const auto start = FencedTicks();
+                sample = FencedTicks() - start;
+            }
+            std::nth_element (samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            return samples[samples.size() / 2];
+        }();
+    return overhead;
+}
+
+double TicksPerSecond() noexcept
+{
+    static const double rate = []()
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const auto ticks = FencedTicks();
+            while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds (20))
+                ;
+            return (FencedTicks() - ticks) / std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+        }();
+    return rate;
+}
+
+double Median (std::vector<double>& samples)
+{
+    const auto median = samples.begin() + samples.size() / 2;
+    std::nth_element (samples.begin(), median, samples.end());
+    return *median;
+}
+
+// Calls are sporadic in production, so each cold call is timed on its own, loading its input
+// included, right after the solution's table and that input are evicted. FullTableSolution
+// only evicts the entry the call looks up: the inputs repeat, so those stay cached otherwise.
+// The same inputs are then timed warm, one call at a time as well, each right after an untimed
+// call on it; those take a few cycles, about what the fenced timing resolves, and BM_Count has
+// their throughput. The manual time is the cold calls' total.
+template <class Solution>
+void BM_CountCold (benchmark::State &state)
+{
+    constexpr size_t calls = 64;
+
+    const auto nums = GenerateNumbers();
+    Solution::Count (42); // Heatup table
+
+    const auto overhead = TicksOverhead();
+    const auto timed = [overhead](const uint32_t* input)
+        {
+            const auto start = FencedTicks();
+            benchmark::DoNotOptimize (Solution::Count (*input));
+            const auto ticks = FencedTicks() - start;
+            return ticks > overhead ? ticks - overhead : 0;
+        };
+
+    std::vector<double> cold;
+    std::vector<double> warm;
+    cold.reserve (state.max_iterations * calls);
+    warm.reserve (state.max_iterations * calls);
+    size_t offset = 0;
+    for (auto _ : state)
     {
-        return GetTable()[n];
+        boost::ignore_unused (_);
+        if (offset + calls > nums.size())
+            offset = 0;
+        const auto* first = nums.data() + offset;
+        offset += calls;
+
+        uint64_t total = 0;
+        for (size_t ii = 0; ii < calls; ++ii)
+        {
+            if constexpr (HasTable<Solution>::value)
+                CacheFlush::Range (Solution::Table().data(), sizeof (Solution::Table()));
+            if constexpr (HasEntry<Solution>::value)
+                CacheFlush::Range (Solution::Entry (first[ii]), sizeof (*Solution::Entry (first[ii])));
+            CacheFlush::Range (first + ii, sizeof (*first));
+
+            const auto ticks = timed (first + ii);
+            total += ticks;
+            cold.push_back (ticks);
+        }
+        state.SetIterationTime (total / TicksPerSecond());
+
+        for (size_t ii = 0; ii < calls; ++ii)
+        {
+            benchmark::DoNotOptimize (Solution::Count (first[ii]));
+            warm.push_back (timed (first + ii));
+        }
     }
-};
 
-auto GenerateNumbers()
+    state.SetItemsProcessed (state.iterations() * calls);
+    // Medians, since interrupts only ever add time
+    state.counters["cold_ns"] = Median (cold) / TicksPerSecond() * 1e9;
+    state.counters["warm_ns"] = Median (warm) / TicksPerSecond() * 1e9;
+}
+
+// A fixed count of samples: the cold calls take far less manual time than their evictions
+#define COLD_ARGS UseManualTime()->Iterations (2000)
+
+BENCHMARK_TEMPLATE(BM_CountCold, ReferenceSolution)->COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_CountCold, AsmSolution)->COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_CountCold, MagicSolution)->COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_CountCold, ByteTableSolution)->COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_CountCold, ElevenBitsTableSolution)->COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_CountCold, WordsTableSolution)->COLD_ARGS;
+BENCHMARK_TEMPLATE(BM_CountCold, FullTableSolution)->COLD_ARGS;
+
+#undef COLD_ARGS
+
+std::vector<uint32_t> GenerateNumbers (size_t size)
 {
-    std::array<uint32_t, 100000> res;
+    std::vector<uint32_t> res (size);
 
     std::mt19937 gen(42);
     std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
@@ -151,51 +323,85 @@ auto GenerateNumbers()
 }
 
 template <class Solution>
-void BM_Count (benchmark::State &state)
+void BM_CountBulk (benchmark::State &state)
 {
-    const auto nums = GenerateNumbers();
-    Solution::Count (42); // Heatup table
+    const auto nums = GenerateNumbers (state.range (0));
+    CountBulk<Solution> (nums.data(), 1); // Heatup table
 
     for (auto _ : state)
     {
         boost::ignore_unused (_);
-        for (auto num : nums)
-            benchmark::DoNotOptimize (Solution::Count (num));
+        benchmark::DoNotOptimize (CountBulk<Solution> (nums.data(), nums.size()));
         state.SetItemsProcessed (state.items_processed() + nums.size());
     }
 }
 
-BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution);
-BENCHMARK_TEMPLATE(BM_Count, AsmSolution);
-BENCHMARK_TEMPLATE(BM_Count, MagicSolution);
-BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution);
-BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution);
-BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution);
-BENCHMARK_TEMPLATE(BM_Count, FullTableSolution);
+void BestCountSizes (benchmark::internal::Benchmark* bench)
+{
+    for (auto size : g_bestCountSizeClasses)
+        bench->Arg (size);
+}
 
-BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution)->Threads (2);
-BENCHMARK_TEMPLATE(BM_Count, AsmSolution)->Threads (2);
-BENCHMARK_TEMPLATE(BM_Count, MagicSolution)->Threads (2);
-BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution)->Threads (2);
-BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution)->Threads (2);
-BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution)->Threads (2);
-BENCHMARK_TEMPLATE(BM_Count, FullTableSolution)->Threads (2);
+BENCHMARK_TEMPLATE(BM_CountBulk, BestCount)->Apply (BestCountSizes);
+#define BULK(Solution) BENCHMARK_TEMPLATE(BM_CountBulk, Solution)->Apply (BestCountSizes);
+BEST_COUNT_CANDIDATES(BULK)
+#undef BULK
 
-BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution)->Threads (4);
-BENCHMARK_TEMPLATE(BM_Count, AsmSolution)->Threads (4);
-BENCHMARK_TEMPLATE(BM_Count, MagicSolution)->Threads (4);
-BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution)->Threads (4);
-BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution)->Threads (4);
-BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution)->Threads (4);
-BENCHMARK_TEMPLATE(BM_Count, FullTableSolution)->Threads (4);
+// Noise of the median paired timings below
+constexpr double g_bestCountMargin = 0.05;
 
-BENCHMARK_TEMPLATE(BM_Count, ReferenceSolution)->Threads (8);
-BENCHMARK_TEMPLATE(BM_Count, AsmSolution)->Threads (8);
-BENCHMARK_TEMPLATE(BM_Count, MagicSolution)->Threads (8);
-BENCHMARK_TEMPLATE(BM_Count, ByteTableSolution)->Threads (8);
-BENCHMARK_TEMPLATE(BM_Count, ElevenBitsTableSolution)->Threads (8);
-BENCHMARK_TEMPLATE(BM_Count, WordsTableSolution)->Threads (8);
-BENCHMARK_TEMPLATE(BM_Count, FullTableSolution)->Threads (8);
+// Times BestCount against every fixed candidate on the same input. vs_<Solution> above 1 means
+// BestCount is faster. More than g_bestCountMargin behind any of them fails: the tuning is
+// stale, or the untuned defaults do not suit this host and the autotune target should be run.
+void BM_BestCountCheck (benchmark::State &state)
+{
+    const auto nums = GenerateNumbers (state.range (0));
+    const auto repeats = std::max<size_t> (1, (1 << 18) / nums.size());
+
+    // Warmed up and long enough to dwarf the clock overhead
+    const auto time = [&nums, repeats](auto count)
+    {
+        benchmark::DoNotOptimize (count (nums.data(), nums.size()));
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t ii = 0; ii < repeats; ++ii)
+            benchmark::DoNotOptimize (count (nums.data(), nums.size()));
+        return std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Each candidate is timed next to BestCount, so that both see the same host load, and
+    // goes first on every other iteration, so that neither gains from the order
+    std::vector<double> ratios[std::size (g_bestCountCandidateNames)];
+    bool bestFirst = true;
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        size_t candidate = 0;
+#define TIME(Solution) \
+        { \
+            const auto first = bestFirst ? time (CountBulk<BestCount>) : time (CountBulk<Solution>); \
+            const auto second = bestFirst ? time (CountBulk<Solution>) : time (CountBulk<BestCount>); \
+            ratios[candidate++].push_back (bestFirst ? second / first : first / second); \
+        }
+        BEST_COUNT_CANDIDATES(TIME)
+#undef TIME
+        bestFirst = !bestFirst;
+        state.SetItemsProcessed (state.items_processed() + nums.size() * repeats * std::size (ratios) * 2);
+    }
+
+    for (size_t candidate = 0; candidate < std::size (ratios); ++candidate)
+    {
+        auto& samples = ratios[candidate];
+        const auto median = samples.begin() + samples.size() / 2;
+        std::nth_element (samples.begin(), median, samples.end());
+        state.counters[std::string ("vs_") + g_bestCountCandidateNames[candidate]] = *median;
+        if (*median < 1 - g_bestCountMargin)
+            state.SkipWithError ((std::string ("BestCount loses to ") + g_bestCountCandidateNames[candidate]).c_str());
+    }
+
+    state.SetLabel (g_bestCountTuned ? "tuned" : "untuned defaults");
+}
+
+BENCHMARK (BM_BestCountCheck)->Apply (BestCountSizes)->Iterations (21);
 
 void BM_CountCheck (benchmark::State &state)
 {
@@ -214,10 +420,11 @@ void BM_CountCheck (benchmark::State &state)
                     ElevenBitsTableSolution::Count (num),
                     WordsTableSolution::Count (num),
                     MagicSolution::Count (num),
+                    ConstantTimeSolution::Count (num),
                     FullTableSolution::Count (num)
                 };
 
-            if (std::count (std::cbegin (ress), std::cend (ress), etalon) != std::size (ress)) 
+            if (static_cast<size_t> (std::count (std::cbegin (ress), std::cend (ress), etalon)) != std::size (ress)) 
                 throw std::runtime_error ("test");
         }
 
@@ -225,4 +432,31 @@ void BM_CountCheck (benchmark::State &state)
     }
 }
 
-BENCHMARK (BM_CountCheck);
\ No newline at end of file
+BENCHMARK (BM_CountCheck);
+
+// Bulk kernels against the per-word reference, over every short length to cover the tails
+void BM_CountBulkCheck (benchmark::State &state)
+{
+    const auto nums = GenerateNumbers();
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t size = 0; size <= nums.size(); size = size < 512 ? size + 1 : size * 2 + 1)
+        {
+            const auto etalon = CountBulk<ReferenceSolution> (nums.data(), size);
+            const uint64_t ress[] =
+                {
+                    CountBulk<Avx2Solution> (nums.data(), size),
+                    CountBulk<BestCount> (nums.data(), size)
+                };
+
+            if (static_cast<size_t> (std::count (std::cbegin (ress), std::cend (ress), etalon)) != std::size (ress))
+                throw std::runtime_error ("test");
+
+            state.SetItemsProcessed (state.items_processed() + size);
+        }
+    }
+}
+
+BENCHMARK (BM_CountBulkCheck);
\ No newline at end of file
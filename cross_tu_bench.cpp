@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "kernels.h"
+
+// Calls the kernels API inlined from the header, across a translation unit boundary
+// without LTO, and across the same boundary with LTO (this executable is linked with -flto).
+
+#define KERNELS_OUTLINE_DECLARE(Namespace) \
+    namespace Namespace \
+    { \
+        uint32_t PopCount (uint32_t n) noexcept; \
+        uint64_t PopCountBulk (const uint32_t* data, size_t size) noexcept; \
+        int ReverseDigits (int x) noexcept; \
+    }
+
+KERNELS_OUTLINE_DECLARE(outline)
+KERNELS_OUTLINE_DECLARE(outline_lto)
+
+#undef KERNELS_OUTLINE_DECLARE
+
+#define KERNELS_CALLER(Name, Namespace) \
+    struct Name \
+    { \
+        static uint32_t PopCount (uint32_t n) noexcept { return Namespace::PopCount (n); } \
+        static uint64_t PopCountBulk (const uint32_t* data, size_t size) noexcept { return Namespace::PopCountBulk (data, size); } \
+        static int ReverseDigits (int x) noexcept { return Namespace::ReverseDigits (x); } \
+    };
+
+KERNELS_CALLER(Inline, kernels)
+KERNELS_CALLER(CrossTU, outline)
+KERNELS_CALLER(CrossTULto, outline_lto)
+
+#undef KERNELS_CALLER
+
+auto GenerateNumbers()
+{
+    std::array<uint32_t, 100000> res;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
+
+    const auto generator = [&gen, &dist]() { return dist(gen); };
+
+    std::generate (res.begin(), res.end(), generator);
+
+    return res;
+}
+
+template <class Caller>
+void BM_CallPopCount (benchmark::State &state)
+{
+    const auto nums = GenerateNumbers();
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (auto num : nums)
+            benchmark::DoNotOptimize (Caller::PopCount (num));
+        state.SetItemsProcessed (state.items_processed() + nums.size());
+    }
+}
+
+template <class Caller>
+void BM_CallPopCountBulk (benchmark::State &state)
+{
+    const auto nums = GenerateNumbers();
+    const size_t size = state.range (0);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t offset = 0; offset + size <= nums.size(); offset += size)
+            benchmark::DoNotOptimize (Caller::PopCountBulk (nums.data() + offset, size));
+        state.SetItemsProcessed (state.items_processed() + nums.size() / size * size);
+    }
+}
+
+template <class Caller>
+void BM_CallReverseDigits (benchmark::State &state)
+{
+    const auto nums = GenerateNumbers();
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (auto num : nums)
+            benchmark::DoNotOptimize (Caller::ReverseDigits (static_cast<int> (num)));
+        state.SetItemsProcessed (state.items_processed() + nums.size());
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_CallPopCount, Inline);
+BENCHMARK_TEMPLATE(BM_CallPopCount, CrossTU);
+BENCHMARK_TEMPLATE(BM_CallPopCount, CrossTULto);
+
+BENCHMARK_TEMPLATE(BM_CallPopCountBulk, Inline)->RangeMultiplier (8)->Range (8, 4096);
+BENCHMARK_TEMPLATE(BM_CallPopCountBulk, CrossTU)->RangeMultiplier (8)->Range (8, 4096);
+BENCHMARK_TEMPLATE(BM_CallPopCountBulk, CrossTULto)->RangeMultiplier (8)->Range (8, 4096);
+
+BENCHMARK_TEMPLATE(BM_CallReverseDigits, Inline);
+BENCHMARK_TEMPLATE(BM_CallReverseDigits, CrossTU);
+BENCHMARK_TEMPLATE(BM_CallReverseDigits, CrossTULto);
+
+// Every caller against the reference solutions, bulk sizes leaving partial vectors included
+template <class Caller>
+void BM_CallCheck (benchmark::State &state)
+{
+    const auto nums = GenerateNumbers();
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t ii = 0; ii < 1000; ++ii)
+            if (Caller::PopCount (nums[ii]) != ReferenceSolution::Count (nums[ii]) ||
+                Caller::ReverseDigits (static_cast<int> (nums[ii])) != reverse_int::ReferenceSolution::reverse (static_cast<int> (nums[ii])))
+                throw std::runtime_error ("test");
+
+        for (size_t size : {0, 1, 7, 8, 63, 1000, 4097})
+        {
+            uint64_t etalon = 0;
+            for (size_t ii = 0; ii < size; ++ii)
+                etalon += ReferenceSolution::Count (nums[ii]);
+            if (Caller::PopCountBulk (nums.data(), size) != etalon)
+                throw std::runtime_error ("test");
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_CallCheck, Inline);
+BENCHMARK_TEMPLATE(BM_CallCheck, CrossTU);
+BENCHMARK_TEMPLATE(BM_CallCheck, CrossTULto);
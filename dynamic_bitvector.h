@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "count_bits.h"
+
+// Rank (ones before a position) over a bitmap that keeps changing. Bits live in 512-bit
+// blocks, a cache line each. DynamicBitvector keeps the block counts in a tree of cache-line
+// nodes (or a Fenwick array), so set / clear and rank are O(log blocks). RebuiltBitvector is
+// the static alternative: cumulative block counts recomputed with CountBulk before the first
+// rank after a change. Both hold fewer than 2^32 bits.
+
+namespace dynamic_bitvector
+{
+
+constexpr size_t g_blockWords = 16;
+constexpr size_t g_blockBits = 32 * g_blockWords;
+
+struct Update
+{
+    uint32_t position;
+    bool value;
+};
+
+// Ones among the first `bits` bits of a block
+template <class Solution>
+uint32_t BlockRank (const uint32_t* block, size_t bits) noexcept
+{
+    auto res = static_cast<uint32_t> (CountBulk<Solution> (block, bits / 32));
+    if (bits % 32)
+    {
+        const uint32_t partial = block[bits / 32] & ((1u << (bits % 32)) - 1);
+        res += static_cast<uint32_t> (CountBulk<Solution> (&partial, 1));
+    }
+    return res;
+}
+
+// Words padded to whole blocks
+inline size_t BlockCount (size_t bits) noexcept
+{
+    return (bits + g_blockBits - 1) / g_blockBits;
+}
+
+// Block counts as an implicit Fenwick array, 4 bytes per block. A prefix sum or an update
+// visits up to log2(blocks) entries spread over as many cache lines.
+class FenwickCounts
+{
+public:
+    explicit FenwickCounts (size_t blocks)
+        : m_tree (blocks)
+    {
+    }
+
+    // Entries one Add writes, against one per block for AddAll
+    size_t UpdateCost() const noexcept
+    {
+        size_t res = 1;
+        while ((size_t (1) << res) < m_tree.size())
+            ++res;
+        return res;
+    }
+
+    // Sum of the counts of blocks [0, block)
+    uint32_t Prefix (size_t block) const noexcept
+    {
+        uint32_t res = 0;
+        for (auto jj = block; jj; jj &= jj - 1)
+            res += m_tree[jj - 1];
+        return res;
+    }
+
+    void Add (size_t block, uint32_t delta) noexcept
+    {
+        for (auto jj = block + 1; jj <= m_tree.size(); jj += jj & (~jj + 1))
+            m_tree[jj - 1] += delta;
+    }
+
+    // The tree is linear in the block counts, so the tree of the deltas is built in place in
+    // O(blocks) and added on top
+    void AddAll (std::vector<uint32_t>& deltas) noexcept
+    {
+        for (size_t jj = 1; jj <= deltas.size(); ++jj)
+        {
+            const auto parent = jj + (jj & (~jj + 1));
+            if (parent <= deltas.size())
+                deltas[parent - 1] += deltas[jj - 1];
+        }
+        for (size_t jj = 0; jj < m_tree.size(); ++jj)
+            m_tree[jj] += deltas[jj];
+    }
+
+private:
+    std::vector<uint32_t> m_tree;
+};
+
+// Block counts as a 16-ary tree with one node per cache line. A node keeps the running sums
+// of its 16 children's totals, so a prefix sum reads one entry per level and an update adds
+// to the tail of one line per level: log16(blocks) lines, against log2(blocks) for Fenwick.
+// Levels are stored leaves first; the last one is the single root.
+class BTreeCounts
+{
+public:
+    static constexpr size_t g_fanout = 16;
+
+    explicit BTreeCounts (size_t blocks)
+    {
+        size_t nodes = blocks;
+        do
+        {
+            nodes = (nodes + g_fanout - 1) / g_fanout;
+            m_levels.push_back (m_nodes.size());
+            m_nodes.resize (m_nodes.size() + nodes);
+        }
+        while (nodes > 1);
+    }
+
+    // One line per level, added 4 entries at a time with SSE2
+    size_t UpdateCost() const noexcept
+    {
+        return m_levels.size() * g_fanout / 4;
+    }
+
+    uint32_t Prefix (size_t block) const noexcept
+    {
+        uint32_t res = 0;
+        for (const auto level : m_levels)
+        {
+            if (const auto child = block % g_fanout)
+                res += m_nodes[level + block / g_fanout].sums[child - 1];
+            block /= g_fanout;
+        }
+        return res;
+    }
+
+    // Adds to the whole line with the entries before the child masked off, so that the
+    // stores are full-width and the next update's loads forward from them. Entries past a
+    // node's last child are never read, so they take the delta as well.
+    void Add (size_t block, uint32_t delta) noexcept
+    {
+        for (const auto level : m_levels)
+        {
+            auto& node = m_nodes[level + block / g_fanout];
+            const auto first = static_cast<uint32_t> (block % g_fanout);
+            for (uint32_t child = 0; child < g_fanout; ++child)
+                node.sums[child] += child >= first ? delta : 0;
+            block /= g_fanout;
+        }
+    }
+
+    // One pass per level; each level's node totals are the deltas of the next
+    void AddAll (std::vector<uint32_t>& deltas) noexcept
+    {
+        for (size_t ll = 0; ll < m_levels.size(); ++ll)
+        {
+            const auto nodes = (ll + 1 < m_levels.size() ? m_levels[ll + 1] : m_nodes.size()) - m_levels[ll];
+            for (size_t nn = 0; nn < nodes; ++nn)
+            {
+                auto& node = m_nodes[m_levels[ll] + nn];
+                uint32_t sum = 0;
+                for (size_t child = 0; child < g_fanout; ++child)
+                {
+                    if (nn * g_fanout + child < deltas.size())
+                        sum += deltas[nn * g_fanout + child];
+                    node.sums[child] += sum;
+                }
+                deltas[nn] = sum;
+            }
+            deltas.resize (nodes);
+        }
+    }
+
+private:
+    struct alignas(64) Node
+    {
+        uint32_t sums[g_fanout] = {};
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<size_t> m_levels; // index of every level's first node
+};
+
+// Counts is FenwickCounts or BTreeCounts
+template <class Solution, class Counts = BTreeCounts>
+class DynamicBitvector
+{
+public:
+    explicit DynamicBitvector (size_t bits)
+        : m_words (BlockCount (bits) * g_blockWords),
+          m_blocks (BlockCount (bits)),
+          m_counts (m_blocks)
+    {
+    }
+
+    bool Get (size_t position) const noexcept
+    {
+        return (m_words[position / 32] >> (position % 32)) & 1;
+    }
+
+    // Returns whether the bit changed
+    bool Set (size_t position, bool value) noexcept
+    {
+        const auto delta = Write (position, value);
+        if (delta)
+            m_counts.Add (position / g_blockBits, delta);
+        return delta != 0;
+    }
+
+    // Ones in [0, position)
+    uint32_t Rank (size_t position) const noexcept
+    {
+        const auto block = position / g_blockBits;
+        auto res = m_counts.Prefix (block);
+        if (position % g_blockBits)
+            res += BlockRank<Solution> (&m_words[block * g_blockWords], position % g_blockBits);
+        return res;
+    }
+
+    // Batches touching many blocks are cheaper as one linear pass over the per-block deltas
+    void Apply (const Update* updates, size_t size)
+    {
+        if (size * m_counts.UpdateCost() < m_blocks)
+        {
+            for (size_t ii = 0; ii < size; ++ii)
+                Set (updates[ii].position, updates[ii].value);
+            return;
+        }
+
+        std::vector<uint32_t> deltas (m_blocks);
+        for (size_t ii = 0; ii < size; ++ii)
+            deltas[updates[ii].position / g_blockBits] += Write (updates[ii].position, updates[ii].value);
+        m_counts.AddAll (deltas);
+    }
+
+private:
+    // Returns the change in the block count, modulo 2^32
+    uint32_t Write (size_t position, bool value) noexcept
+    {
+        auto& word = m_words[position / 32];
+        const auto bit = 1u << (position % 32);
+        if (bool (word & bit) == value)
+            return 0;
+        word ^= bit;
+        return value ? 1 : ~0u;
+    }
+
+    std::vector<uint32_t> m_words;
+    size_t m_blocks;
+    Counts m_counts;
+};
+
+// Static rank index rebuilt lazily: updates only mark it stale, the next rank recounts the
+// whole bitmap into cumulative block counts
+template <class Solution>
+class RebuiltBitvector
+{
+public:
+    explicit RebuiltBitvector (size_t bits)
+        : m_words (BlockCount (bits) * g_blockWords),
+          m_cumulative (BlockCount (bits) + 1)
+    {
+    }
+
+    bool Get (size_t position) const noexcept
+    {
+        return (m_words[position / 32] >> (position % 32)) & 1;
+    }
+
+    bool Set (size_t position, bool value) noexcept
+    {
+        auto& word = m_words[position / 32];
+        const auto bit = 1u << (position % 32);
+        if (bool (word & bit) == value)
+            return false;
+        word ^= bit;
+        m_stale = true;
+        return true;
+    }
+
+    uint32_t Rank (size_t position) noexcept
+    {
+        if (m_stale)
+            Rebuild();
+
+        const auto block = position / g_blockBits;
+        auto res = m_cumulative[block];
+        if (position % g_blockBits)
+            res += BlockRank<Solution> (&m_words[block * g_blockWords], position % g_blockBits);
+        return res;
+    }
+
+    void Apply (const Update* updates, size_t size) noexcept
+    {
+        for (size_t ii = 0; ii < size; ++ii)
+            Set (updates[ii].position, updates[ii].value);
+    }
+
+private:
+    void Rebuild() noexcept
+    {
+        for (size_t block = 0; block + 1 < m_cumulative.size(); ++block)
+            m_cumulative[block + 1] = m_cumulative[block] +
+                static_cast<uint32_t> (CountBulk<Solution> (&m_words[block * g_blockWords], g_blockWords));
+        m_stale = false;
+    }
+
+    std::vector<uint32_t> m_words;
+    std::vector<uint32_t> m_cumulative;
+    bool m_stale = false;
+};
+
+}
@@ -0,0 +1,157 @@
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "best_count.h"
+#include "dynamic_bitvector.h"
+
+using dynamic_bitvector::BTreeCounts;
+using dynamic_bitvector::DynamicBitvector;
+using dynamic_bitvector::FenwickCounts;
+using dynamic_bitvector::RebuiltBitvector;
+using dynamic_bitvector::Update;
+
+namespace
+{
+
+// Rounds of the workload are cycled through. The second half undoes the first, so that
+// updates keep flipping bits rather than rewriting the values of the last lap.
+constexpr size_t g_rounds = 128;
+
+std::vector<Update> RandomUpdates (size_t size, size_t bits, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> position(0, static_cast<uint32_t> (bits - 1));
+    std::vector<Update> res (size);
+    for (auto& update : res)
+        update = {position(gen), (gen() & 1) != 0};
+    return res;
+}
+
+std::vector<uint32_t> RandomPositions (size_t size, size_t bits, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> position(0, static_cast<uint32_t> (bits));
+    std::vector<uint32_t> res (size);
+    for (auto& pos : res)
+        pos = position(gen);
+    return res;
+}
+
+}
+
+// Args: bits, updates per round, ranks per round. A round applies its updates as one batch,
+// then answers its ranks; one item is one update or one rank.
+template <class Bitvector>
+void BM_DynamicRank (benchmark::State &state)
+{
+    const size_t bits = state.range (0);
+    const size_t batch = state.range (1);
+    const size_t queries = state.range (2);
+
+    Bitvector bitvector (bits);
+    bitvector.Apply (RandomUpdates (bits / 2, bits, 1).data(), bits / 2);
+    auto updates = RandomUpdates (g_rounds / 2 * batch, bits, 2);
+    for (size_t ii = 0, half = updates.size(); ii < half; ++ii)
+        updates.push_back ({updates[ii].position, !updates[ii].value});
+    const auto positions = RandomPositions (g_rounds * queries, bits, 3);
+
+    size_t round = 0;
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        bitvector.Apply (updates.data() + round * batch, batch);
+        uint32_t sum = 0;
+        for (size_t ii = 0; ii < queries; ++ii)
+            sum += bitvector.Rank (positions[round * queries + ii]);
+        benchmark::DoNotOptimize (sum);
+        round = (round + 1) % g_rounds;
+    }
+
+    state.SetItemsProcessed (state.iterations() * (batch + queries));
+}
+
+static void RankArgs (benchmark::internal::Benchmark* b)
+{
+    b->ArgNames ({"bits", "batch", "ranks"});
+    for (int64_t bits : {1 << 20, 1 << 24})
+        for (int64_t batch : {1, 64, 4096})
+            for (int64_t queries : {1, 64})
+                b->Args ({bits, batch, queries});
+}
+
+BENCHMARK_TEMPLATE(BM_DynamicRank, DynamicBitvector<AsmSolution, BTreeCounts>)->Apply (RankArgs);
+BENCHMARK_TEMPLATE(BM_DynamicRank, DynamicBitvector<AsmSolution, FenwickCounts>)->Apply (RankArgs);
+BENCHMARK_TEMPLATE(BM_DynamicRank, DynamicBitvector<MagicSolution, BTreeCounts>)->Apply (RankArgs);
+BENCHMARK_TEMPLATE(BM_DynamicRank, RebuiltBitvector<AsmSolution>)->Apply (RankArgs);
+BENCHMARK_TEMPLATE(BM_DynamicRank, RebuiltBitvector<Avx2Solution>)->Apply (RankArgs);
+BENCHMARK_TEMPLATE(BM_DynamicRank, RebuiltBitvector<BestCount>)->Apply (RankArgs);
+
+// The bitvectors against a vector<bool> after single sets and after batches taking either
+// Apply path, ranks at every block boundary and at random positions
+void BM_DynamicRankCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t bits : {1, 511, 513, 100000})
+        {
+            DynamicBitvector<AsmSolution, BTreeCounts> dynamic (bits);
+            DynamicBitvector<AsmSolution, FenwickCounts> fenwick (bits);
+            RebuiltBitvector<MagicSolution> rebuilt (bits);
+            std::vector<bool> etalon (bits);
+
+            const auto check = [&]()
+                {
+                    auto positions = RandomPositions (100, bits, static_cast<uint32_t> (bits));
+                    for (size_t pos = 0; pos <= bits; pos += dynamic_bitvector::g_blockBits)
+                        positions.push_back (static_cast<uint32_t> (pos));
+                    positions.push_back (static_cast<uint32_t> (bits));
+
+                    for (auto pos : positions)
+                    {
+                        uint32_t rank = 0;
+                        for (size_t ii = 0; ii < pos; ++ii)
+                            rank += etalon[ii];
+                        if (dynamic.Rank (pos) != rank || fenwick.Rank (pos) != rank || rebuilt.Rank (pos) != rank)
+                            throw std::runtime_error ("test");
+                    }
+                };
+
+            uint32_t seed = 7;
+            for (size_t size : {1, 2, 5, 20, 1000, 50000})
+            {
+                const auto updates = RandomUpdates (size, bits, ++seed);
+                if (size <= 5)
+                    for (const auto& update : updates)
+                    {
+                        const bool changed = etalon[update.position] != update.value;
+                        etalon[update.position] = update.value;
+                        if (dynamic.Set (update.position, update.value) != changed ||
+                            fenwick.Set (update.position, update.value) != changed ||
+                            rebuilt.Set (update.position, update.value) != changed)
+                            throw std::runtime_error ("test");
+                    }
+                else
+                {
+                    for (const auto& update : updates)
+                        etalon[update.position] = update.value;
+                    dynamic.Apply (updates.data(), size);
+                    fenwick.Apply (updates.data(), size);
+                    rebuilt.Apply (updates.data(), size);
+                }
+
+                for (size_t ii = 0; ii < bits; ++ii)
+                    if (dynamic.Get (ii) != etalon[ii] || fenwick.Get (ii) != etalon[ii] || rebuilt.Get (ii) != etalon[ii])
+                        throw std::runtime_error ("test");
+                check();
+            }
+        }
+    }
+}
+
+BENCHMARK (BM_DynamicRankCheck);
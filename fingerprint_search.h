@@ -0,0 +1,380 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "count_bits.h"
+#include "count_bits_avx2.h"
+#include "parallel_for.h"
+
+// Top-k nearest neighbors over fixed-size binary fingerprints. Both metrics come down to one
+// popcount per database word once every fingerprint's own popcount is stored next to it:
+// Hamming is popcount(q ^ d), Tanimoto is c / (|q| + |d| - c) with c = popcount(q & d).
+
+namespace fingerprint
+{
+
+template <size_t Bits>
+struct Database
+{
+    static constexpr size_t g_words = Bits / 64;
+    static_assert (Bits % 256 == 0, "fingerprints are whole 256-bit blocks");
+
+    void Add (const uint64_t* fp)
+    {
+        const auto count = static_cast<uint32_t> (CountBulk<AsmSolution> (reinterpret_cast<const uint32_t*> (fp), g_words * 2));
+        words.insert (words.end(), fp, fp + g_words);
+        counts.push_back (count);
+    }
+
+    size_t Size() const noexcept
+    {
+        return counts.size();
+    }
+
+    const uint64_t* Get (size_t ii) const noexcept
+    {
+        return words.data() + ii * g_words;
+    }
+
+    std::vector<uint64_t> words;
+    std::vector<uint32_t> counts;
+};
+
+// Ordered by distance, then id, so that every exact search returns the very same set
+struct Hit
+{
+    float distance;
+    uint32_t id;
+
+    bool operator< (const Hit& other) const noexcept
+    {
+        return distance < other.distance || (distance == other.distance && id < other.id);
+    }
+
+    bool operator== (const Hit& other) const noexcept
+    {
+        return distance == other.distance && id == other.id;
+    }
+};
+
+struct Hamming
+{
+    struct Op
+    {
+        static uint64_t Apply (uint64_t a, uint64_t b) noexcept { return a ^ b; }
+
+        __attribute__((target("avx2")))
+        static __m256i Apply (__m256i a, __m256i b) noexcept { return _mm256_xor_si256 (a, b); }
+
+        __attribute__((target("avx512f")))
+        static __m512i Apply (__m512i a, __m512i b) noexcept { return _mm512_xor_si512 (a, b); }
+    };
+
+    static float Distance (uint32_t x, uint32_t, uint32_t) noexcept
+    {
+        return static_cast<float> (x);
+    }
+
+    // Lower bound on the distance to any fingerprint of popcount `d`
+    static float Bound (uint32_t q, uint32_t d) noexcept
+    {
+        return static_cast<float> (q > d ? q - d : d - q);
+    }
+};
+
+// As a distance, 1 - similarity
+struct Tanimoto
+{
+    struct Op
+    {
+        static uint64_t Apply (uint64_t a, uint64_t b) noexcept { return a & b; }
+
+        __attribute__((target("avx2")))
+        static __m256i Apply (__m256i a, __m256i b) noexcept { return _mm256_and_si256 (a, b); }
+
+        __attribute__((target("avx512f")))
+        static __m512i Apply (__m512i a, __m512i b) noexcept { return _mm512_and_si512 (a, b); }
+    };
+
+    static float Distance (uint32_t common, uint32_t q, uint32_t d) noexcept
+    {
+        const auto all = q + d - common;
+        return all ? 1.0f - static_cast<float> (common) / all : 0.0f;
+    }
+
+    static float Bound (uint32_t q, uint32_t d) noexcept
+    {
+        const auto hi = std::max (q, d);
+        return hi ? 1.0f - static_cast<float> (std::min (q, d)) / hi : 0.0f;
+    }
+};
+
+// Kernels write popcount(Op(q, d_i)) for n consecutive fingerprints
+
+template <class Solution>
+struct ScalarKernel
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    template <size_t Words, class Op>
+    static void Counts (const uint64_t* q, const uint64_t* db, size_t n, uint32_t* out) noexcept
+    {
+        for (size_t ii = 0; ii < n; ++ii, db += Words)
+        {
+            uint32_t count = 0;
+            for (size_t jj = 0; jj < Words; ++jj)
+            {
+                const auto word = Op::Apply (q[jj], db[jj]);
+                count += Solution::Count (static_cast<uint32_t> (word)) + Solution::Count (static_cast<uint32_t> (word >> 32));
+            }
+            out[ii] = count;
+        }
+    }
+};
+
+// The vpshufb nibble lookup of CountBulkAvx2 over 256-bit blocks, byte counts summed once per
+// fingerprint with vpsadbw
+struct Avx2Kernel
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx2");
+    }
+
+    template <size_t Words, class Op>
+    __attribute__((target("avx2")))
+    static void Counts (const uint64_t* q, const uint64_t* db, size_t n, uint32_t* out) noexcept
+    {
+        static_assert (Words / 4 * 8 < 256, "a byte lane must hold a whole fingerprint's count");
+
+        __m256i qv[Words / 4];
+        for (size_t cc = 0; cc < Words / 4; ++cc)
+            qv[cc] = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (q + cc * 4));
+
+        for (size_t ii = 0; ii < n; ++ii, db += Words)
+        {
+            auto bytes = ByteCountsAvx2 (Op::Apply (qv[0], _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (db))));
+            for (size_t cc = 1; cc < Words / 4; ++cc)
+                bytes = _mm256_add_epi8 (bytes,
+                    ByteCountsAvx2 (Op::Apply (qv[cc], _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (db + cc * 4)))));
+
+            const auto sums = _mm256_sad_epu8 (bytes, _mm256_setzero_si256());
+            const auto half = _mm_add_epi64 (_mm256_castsi256_si128 (sums), _mm256_extracti128_si256 (sums, 1));
+            out[ii] = static_cast<uint32_t> (_mm_cvtsi128_si64 (half) + _mm_extract_epi64 (half, 1));
+        }
+    }
+};
+
+// vpopcntq over whole cache lines; 256-bit fingerprints go two to a register
+struct Avx512Kernel
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512vpopcntdq");
+    }
+
+    template <size_t Words, class Op>
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static void Counts (const uint64_t* q, const uint64_t* db, size_t n, uint32_t* out) noexcept
+    {
+        if constexpr (Words % 8 == 0)
+        {
+            __m512i qv[Words / 8];
+            for (size_t cc = 0; cc < Words / 8; ++cc)
+                qv[cc] = _mm512_loadu_si512 (q + cc * 8);
+
+            for (size_t ii = 0; ii < n; ++ii, db += Words)
+            {
+                auto acc = _mm512_popcnt_epi64 (Op::Apply (qv[0], _mm512_loadu_si512 (db)));
+                for (size_t cc = 1; cc < Words / 8; ++cc)
+                    acc = _mm512_add_epi64 (acc, _mm512_popcnt_epi64 (Op::Apply (qv[cc], _mm512_loadu_si512 (db + cc * 8))));
+                out[ii] = _mm512_reduce_add_epi64 (acc);
+            }
+        }
+        else
+        {
+            static_assert (Words == 4, "256-bit fingerprints are the only ones not filling a register");
+            const auto qv = _mm512_broadcast_i64x4 (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (q)));
+
+            size_t ii = 0;
+            for (; ii + 2 <= n; ii += 2, db += 2 * Words)
+            {
+                const auto counts = _mm512_popcnt_epi64 (Op::Apply (qv, _mm512_loadu_si512 (db)));
+                out[ii] = _mm512_mask_reduce_add_epi64 (0x0F, counts);
+                out[ii + 1] = _mm512_mask_reduce_add_epi64 (0xF0, counts);
+            }
+            if (ii < n)
+                ScalarKernel<AsmSolution>::Counts<Words, Op> (q, db, 1, out + ii);
+        }
+    }
+};
+
+// Bounded max-heap of the k best hits seen so far
+class TopK
+{
+public:
+    explicit TopK (size_t k)
+        : m_k (k)
+    {
+        m_heap.reserve (k);
+    }
+
+    bool Full() const noexcept
+    {
+        return m_heap.size() == m_k;
+    }
+
+    const Hit& Worst() const noexcept
+    {
+        return m_heap.front();
+    }
+
+    void Push (const Hit& hit)
+    {
+        if (!Full())
+        {
+            m_heap.push_back (hit);
+            std::push_heap (m_heap.begin(), m_heap.end());
+        }
+        else if (hit < m_heap.front())
+        {
+            std::pop_heap (m_heap.begin(), m_heap.end());
+            m_heap.back() = hit;
+            std::push_heap (m_heap.begin(), m_heap.end());
+        }
+    }
+
+    const std::vector<Hit>& Hits() const noexcept
+    {
+        return m_heap;
+    }
+
+    std::vector<Hit> Sorted() &&
+    {
+        std::sort_heap (m_heap.begin(), m_heap.end());
+        return std::move (m_heap);
+    }
+
+private:
+    size_t m_k;
+    std::vector<Hit> m_heap;
+};
+
+constexpr size_t g_block = 256;
+
+// Scores fingerprints [first, last) of db into top, reporting position p as ids[p] when given
+template <class Metric, class Kernel, size_t Bits>
+void ScanRange (const Database<Bits>& db, const uint64_t* q, uint32_t qCount, size_t first, size_t last,
+    const uint32_t* ids, TopK& top)
+{
+    constexpr size_t words = Database<Bits>::g_words;
+    uint32_t counts[g_block];
+    for (size_t begin = first; begin < last; begin += g_block)
+    {
+        const auto n = std::min (g_block, last - begin);
+        Kernel::template Counts<words, typename Metric::Op> (q, db.Get (begin), n, counts);
+        for (size_t ii = 0; ii < n; ++ii)
+        {
+            const auto pos = begin + ii;
+            const auto distance = Metric::Distance (counts[ii], qCount, db.counts[pos]);
+            if (!top.Full() || distance <= top.Worst().distance)
+                top.Push ({distance, static_cast<uint32_t> (ids ? ids[pos] : pos)});
+        }
+    }
+}
+
+template <size_t Bits>
+uint32_t Popcount (const uint64_t* q) noexcept
+{
+    return static_cast<uint32_t> (CountBulk<AsmSolution> (reinterpret_cast<const uint32_t*> (q), Database<Bits>::g_words * 2));
+}
+
+// Brute force: every thread keeps its own heap over its share of the database, merged at the end
+template <class Metric, class Kernel, size_t Bits>
+std::vector<Hit> Scan (const Database<Bits>& db, const uint64_t* q, size_t k, size_t threads = 1)
+{
+    const auto qCount = Popcount<Bits> (q);
+    std::vector<TopK> tops (std::max<size_t> (1, threads), TopK (k));
+    ParallelFor (db.Size(), threads, [&](size_t thread, size_t first, size_t last)
+        {
+            ScanRange<Metric, Kernel> (db, q, qCount, first, last, nullptr, tops[thread]);
+        });
+
+    for (size_t tt = 1; tt < tops.size(); ++tt)
+        for (const auto& hit : tops[tt].Hits())
+            tops[0].Push (hit);
+    return std::move (tops[0]).Sorted();
+}
+
+// Fingerprints bucketed by popcount. A query visits buckets in order of Metric::Bound and stops
+// once the bound exceeds its k-th best distance, so the result is exact and equal to Scan's.
+template <size_t Bits>
+class PopcountIndex
+{
+public:
+    explicit PopcountIndex (const Database<Bits>& db)
+        : m_offsets (Bits + 2, 0)
+    {
+        for (auto count : db.counts)
+            ++m_offsets[count + 1];
+        for (size_t ii = 1; ii < m_offsets.size(); ++ii)
+            m_offsets[ii] += m_offsets[ii - 1];
+
+        auto next = m_offsets;
+        m_ids.resize (db.Size());
+        for (size_t ii = 0; ii < db.Size(); ++ii)
+            m_ids[next[db.counts[ii]]++] = static_cast<uint32_t> (ii);
+
+        m_sorted.words.reserve (db.words.size());
+        m_sorted.counts.reserve (db.Size());
+        for (auto id : m_ids)
+            m_sorted.Add (db.Get (id));
+    }
+
+    // `visited`, when given, receives the number of fingerprints scored
+    template <class Metric, class Kernel>
+    std::vector<Hit> Search (const uint64_t* q, size_t k, size_t* visited = nullptr) const
+    {
+        const auto qCount = Popcount<Bits> (q);
+        TopK top (k);
+        size_t scored = 0;
+
+        // Buckets below and above the query's popcount, each side's bound grows monotonically
+        int64_t lo = qCount;
+        int64_t hi = qCount + 1;
+        while (lo >= 0 || hi <= static_cast<int64_t> (Bits))
+        {
+            const auto loBound = lo >= 0 ? Metric::Bound (qCount, lo) : 2.0f * Bits;
+            const auto hiBound = hi <= static_cast<int64_t> (Bits) ? Metric::Bound (qCount, hi) : 2.0f * Bits;
+            const bool takeLo = loBound <= hiBound;
+            const auto bound = takeLo ? loBound : hiBound;
+            if (top.Full() && bound > top.Worst().distance)
+                break;
+
+            const auto bucket = takeLo ? lo-- : hi++;
+            const auto first = m_offsets[bucket];
+            const auto last = m_offsets[bucket + 1];
+            ScanRange<Metric, Kernel> (m_sorted, q, qCount, first, last, m_ids.data(), top);
+            scored += last - first;
+        }
+
+        if (visited)
+            *visited = scored;
+        return std::move (top).Sorted();
+    }
+
+private:
+    std::vector<size_t> m_offsets;
+    std::vector<uint32_t> m_ids;
+    Database<Bits> m_sorted;
+};
+
+}
@@ -0,0 +1,209 @@
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "fingerprint_search.h"
+
+using fingerprint::Avx2Kernel;
+using fingerprint::Avx512Kernel;
+using fingerprint::Database;
+using fingerprint::Hamming;
+using fingerprint::PopcountIndex;
+using fingerprint::ScalarKernel;
+using fingerprint::Tanimoto;
+
+namespace
+{
+
+constexpr size_t g_entries = 1 << 20;
+constexpr size_t g_queries = 64;
+constexpr size_t g_k = 10;
+
+// Bit density varies per fingerprint between 1/16 and 1/2, as with chemical fingerprints,
+// made by and-ing one to four random words
+template <size_t Bits>
+Database<Bits> RandomDatabase (size_t entries, uint32_t seed)
+{
+    std::mt19937_64 gen(seed);
+    Database<Bits> db;
+    db.words.reserve (entries * Database<Bits>::g_words);
+    db.counts.reserve (entries);
+
+    uint64_t fp[Database<Bits>::g_words];
+    for (size_t ii = 0; ii < entries; ++ii)
+    {
+        const auto ands = gen() % 4;
+        for (auto& word : fp)
+        {
+            word = gen();
+            for (size_t jj = 0; jj < ands; ++jj)
+                word &= gen();
+        }
+        db.Add (fp);
+    }
+    return db;
+}
+
+// Database entries with a few bits flipped, so that every query has close neighbors
+template <size_t Bits>
+std::vector<uint64_t> Queries (const Database<Bits>& db, size_t queries, uint32_t seed)
+{
+    std::mt19937_64 gen(seed);
+    std::vector<uint64_t> res;
+    for (size_t ii = 0; ii < queries; ++ii)
+    {
+        const auto* fp = db.Get (gen() % db.Size());
+        res.insert (res.end(), fp, fp + Database<Bits>::g_words);
+        for (size_t jj = 0; jj < Bits / 32; ++jj)
+        {
+            const auto bit = gen() % Bits;
+            res[ii * Database<Bits>::g_words + bit / 64] ^= uint64_t (1) << (bit % 64);
+        }
+    }
+    return res;
+}
+
+template <size_t Bits>
+struct Fixture
+{
+    static const Fixture& Instance()
+    {
+        static const Fixture fixture;
+        return fixture;
+    }
+
+    Database<Bits> db = RandomDatabase<Bits> (g_entries, 42);
+    std::vector<uint64_t> queries = Queries<Bits> (db, g_queries, 7);
+    PopcountIndex<Bits> index {db};
+};
+
+}
+
+// Arg: threads
+template <class Metric, class Kernel, size_t Bits>
+void BM_FingerprintScan (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const auto& fixture = Fixture<Bits>::Instance();
+    size_t query = 0;
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        const auto* q = fixture.queries.data() + query++ % g_queries * Database<Bits>::g_words;
+        benchmark::DoNotOptimize (fingerprint::Scan<Metric, Kernel> (fixture.db, q, g_k, state.range (0)));
+    }
+
+    state.SetItemsProcessed (state.iterations());
+    state.SetBytesProcessed (state.iterations() * fixture.db.words.size() * sizeof (uint64_t));
+}
+
+// Queries/s through the popcount index, with its recall and the share of the database it
+// scored, both against the linear scan
+template <class Metric, class Kernel, size_t Bits>
+void BM_FingerprintIndex (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const auto& fixture = Fixture<Bits>::Instance();
+    size_t found = 0;
+    size_t visited = 0;
+    for (size_t ii = 0; ii < g_queries; ++ii)
+    {
+        const auto* q = fixture.queries.data() + ii * Database<Bits>::g_words;
+        const auto exact = fingerprint::Scan<Metric, Kernel> (fixture.db, q, g_k);
+        size_t scored = 0;
+        const auto hits = fixture.index.template Search<Metric, Kernel> (q, g_k, &scored);
+        visited += scored;
+        for (const auto& hit : hits)
+            found += std::count (exact.begin(), exact.end(), hit);
+    }
+
+    size_t query = 0;
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        const auto* q = fixture.queries.data() + query++ % g_queries * Database<Bits>::g_words;
+        benchmark::DoNotOptimize (fixture.index.template Search<Metric, Kernel> (q, g_k));
+    }
+
+    state.SetItemsProcessed (state.iterations());
+    state.counters["recall"] = static_cast<double> (found) / (g_queries * g_k);
+    state.counters["scored"] = static_cast<double> (visited) / (g_queries * fixture.db.Size());
+}
+
+#define FINGERPRINT(Metric, Bits) \
+    BENCHMARK_TEMPLATE(BM_FingerprintScan, Metric, ScalarKernel<AsmSolution>, Bits)->Arg (1)->Arg (4)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(BM_FingerprintScan, Metric, ScalarKernel<MagicSolution>, Bits)->Arg (1)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(BM_FingerprintScan, Metric, Avx2Kernel, Bits)->Arg (1)->Arg (4)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(BM_FingerprintScan, Metric, Avx512Kernel, Bits)->Arg (1)->Arg (4)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(BM_FingerprintIndex, Metric, ScalarKernel<AsmSolution>, Bits); \
+    BENCHMARK_TEMPLATE(BM_FingerprintIndex, Metric, Avx2Kernel, Bits); \
+    BENCHMARK_TEMPLATE(BM_FingerprintIndex, Metric, Avx512Kernel, Bits);
+
+FINGERPRINT(Hamming, 256)
+FINGERPRINT(Hamming, 512)
+FINGERPRINT(Hamming, 1024)
+FINGERPRINT(Tanimoto, 256)
+FINGERPRINT(Tanimoto, 512)
+FINGERPRINT(Tanimoto, 1024)
+
+#undef FINGERPRINT
+
+// Scan with every kernel and thread count, and the index, against a sort of all distances
+template <class Metric, size_t Bits>
+void BM_FingerprintCheck (benchmark::State &state)
+{
+    const auto db = RandomDatabase<Bits> (5000, 1);
+    const auto queries = Queries<Bits> (db, 16, 2);
+    const PopcountIndex<Bits> index (db);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t ii = 0; ii < 16; ++ii)
+        {
+            const auto* q = queries.data() + ii * Database<Bits>::g_words;
+            const auto qCount = fingerprint::Popcount<Bits> (q);
+
+            std::vector<fingerprint::Hit> all;
+            for (size_t jj = 0; jj < db.Size(); ++jj)
+            {
+                uint32_t count;
+                ScalarKernel<ReferenceSolution>::Counts<Database<Bits>::g_words, typename Metric::Op> (q, db.Get (jj), 1, &count);
+                all.push_back ({Metric::Distance (count, qCount, db.counts[jj]), static_cast<uint32_t> (jj)});
+            }
+            std::sort (all.begin(), all.end());
+            all.resize (g_k);
+
+            for (size_t threads : {1, 3})
+                if (fingerprint::Scan<Metric, ScalarKernel<AsmSolution>> (db, q, g_k, threads) != all ||
+                    fingerprint::Scan<Metric, ScalarKernel<MagicSolution>> (db, q, g_k, threads) != all ||
+                    (Avx2Kernel::Available() && fingerprint::Scan<Metric, Avx2Kernel> (db, q, g_k, threads) != all) ||
+                    (Avx512Kernel::Available() && fingerprint::Scan<Metric, Avx512Kernel> (db, q, g_k, threads) != all))
+                    throw std::runtime_error ("test");
+
+            if (index.template Search<Metric, ScalarKernel<AsmSolution>> (q, g_k) != all ||
+                (Avx2Kernel::Available() && index.template Search<Metric, Avx2Kernel> (q, g_k) != all))
+                throw std::runtime_error ("test");
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_FingerprintCheck, Hamming, 256);
+BENCHMARK_TEMPLATE(BM_FingerprintCheck, Hamming, 1024);
+BENCHMARK_TEMPLATE(BM_FingerprintCheck, Tanimoto, 256);
+BENCHMARK_TEMPLATE(BM_FingerprintCheck, Tanimoto, 512);
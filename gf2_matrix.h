@@ -0,0 +1,262 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "binary_gemm.h"
+#include "count_bits.h"
+#include "parallel_for.h"
+
+// Matrix-vector and matrix-matrix products over GF(2), where addition is xor and
+// multiplication is and, so bit i of A * x is parity(popcount(row_i & x)). The parity path
+// takes one and-xor dot product per output bit and a single popcount per dot. Four Russians
+// (M4R) precomputes all 2^8 xor combinations of every 8 columns of A (rows of B), turning 8
+// conditional row additions into one table lookup.
+
+namespace gf2
+{
+
+// Rows padded to g_rowAlign words, a cache line, bits past the last column are zero
+using binary_gemm::BitMatrix;
+using binary_gemm::g_rowAlign;
+
+// M4R group: one byte of the selecting vector or row of A picks the table entry
+constexpr size_t g_k = 8;
+constexpr size_t g_combinations = size_t (1) << g_k;
+
+// Rows of C per M4R matmul work unit, a 512-bit column block of them stays in L2
+constexpr size_t g_mc = 2048;
+
+// Words of a vector of `bits` bits, padded like a BitMatrix row
+inline size_t VectorWords (size_t bits) noexcept
+{
+    return (bits + 64 * g_rowAlign - 1) / (64 * g_rowAlign) * g_rowAlign;
+}
+
+// Kernels: Dot is parity(popcount(a & b)) over `words` words, a multiple of g_rowAlign;
+// XorLine is dst ^= src over one cache line
+
+template <class Solution>
+struct ScalarKernel
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static uint32_t Dot (const uint64_t* a, const uint64_t* b, size_t words) noexcept
+    {
+        uint64_t acc = 0;
+        for (size_t kk = 0; kk < words; ++kk)
+            acc ^= a[kk] & b[kk];
+        // Folding the halves keeps the parity
+        return Solution::Count (static_cast<uint32_t> (acc ^ (acc >> 32))) & 1;
+    }
+
+    static void XorLine (uint64_t* dst, const uint64_t* src) noexcept
+    {
+        for (size_t kk = 0; kk < g_rowAlign; ++kk)
+            dst[kk] ^= src[kk];
+    }
+};
+
+// vpternlogq and-xor on whole cache lines
+struct Avx512Kernel
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx512f");
+    }
+
+    __attribute__((target("avx512f")))
+    static uint32_t Dot (const uint64_t* a, const uint64_t* b, size_t words) noexcept
+    {
+        auto acc = _mm512_setzero_si512();
+        for (size_t kk = 0; kk < words; kk += g_rowAlign)
+            acc = _mm512_ternarylogic_epi64 (acc, _mm512_loadu_si512 (a + kk), _mm512_loadu_si512 (b + kk), 0x78);
+
+        const auto half = _mm256_xor_si256 (_mm512_castsi512_si256 (acc), _mm512_extracti64x4_epi64 (acc, 1));
+        const auto quarter = _mm_xor_si128 (_mm256_castsi256_si128 (half), _mm256_extracti128_si256 (half, 1));
+        return __builtin_popcountll (_mm_cvtsi128_si64 (quarter) ^ _mm_extract_epi64 (quarter, 1)) & 1;
+    }
+
+    __attribute__((target("avx512f")))
+    static void XorLine (uint64_t* dst, const uint64_t* src) noexcept
+    {
+        _mm512_storeu_si512 (dst, _mm512_xor_si512 (_mm512_loadu_si512 (dst), _mm512_loadu_si512 (src)));
+    }
+};
+
+// In-place transpose of a 64 x 64 block, word ii holding row ii: swaps the off-diagonal
+// quadrants, then the off-diagonal quadrants of every quadrant, down to single bits
+inline void Transpose64 (uint64_t* block) noexcept
+{
+    uint64_t mask = 0x00000000FFFFFFFF;
+    for (size_t width = 32; width; width >>= 1, mask ^= mask << width)
+        for (size_t ii = 0; ii < 64; ii = (ii + width + 1) & ~width)
+        {
+            const auto t = ((block[ii] >> width) ^ block[ii + width]) & mask;
+            block[ii] ^= t << width;
+            block[ii + width] ^= t;
+        }
+}
+
+inline BitMatrix Transpose (const BitMatrix& src)
+{
+    BitMatrix res (src.bits, src.rows);
+    uint64_t block[64];
+    for (size_t rb = 0; rb < src.rows; rb += 64)
+        for (size_t cb = 0; cb < src.bits; cb += 64)
+        {
+            for (size_t ii = 0; ii < 64; ++ii)
+                block[ii] = rb + ii < src.rows ? src.Row (rb + ii)[cb / 64] : 0;
+            Transpose64 (block);
+            for (size_t jj = 0; jj < 64 && cb + jj < res.rows; ++jj)
+                res.data[(cb + jj) * res.stride + rb / 64] = block[jj];
+        }
+    return res;
+}
+
+// table[b] is the xor of rows first + t of src, for every bit t set in b, over `words` words
+// from word `offset`. Rows past the end count as zero. Each entry is one row xor away from
+// the entry with its lowest bit cleared.
+template <class Kernel>
+void BuildTable (const BitMatrix& src, size_t first, size_t offset, size_t words, uint64_t* table) noexcept
+{
+    std::fill (table, table + words, 0);
+    for (size_t bb = 1; bb < g_combinations; ++bb)
+    {
+        auto* entry = table + bb * words;
+        const auto* prev = table + (bb & (bb - 1)) * words;
+        std::copy (prev, prev + words, entry);
+
+        const auto row = first + __builtin_ctz (bb);
+        if (row < src.rows)
+            for (size_t ww = 0; ww < words; ww += g_rowAlign)
+                Kernel::XorLine (entry + ww, src.Row (row) + offset + ww);
+    }
+}
+
+// y = A * x by parity of row dot products. x has at least a.stride words, y VectorWords (a.rows).
+// Threads own whole words of y, padding words included.
+template <class Kernel>
+void MatVec (const BitMatrix& a, const uint64_t* x, uint64_t* y, size_t threads = 1)
+{
+    ParallelFor (VectorWords (a.rows), threads, [&a, x, y](size_t, size_t first, size_t last)
+        {
+            for (size_t ww = first; ww < last; ++ww)
+            {
+                uint64_t word = 0;
+                const auto end = std::min (ww * 64 + 64, a.rows);
+                for (size_t ii = ww * 64; ii < end; ++ii)
+                    word |= uint64_t (Kernel::Dot (a.Row (ii), x, a.stride)) << (ii % 64);
+                y[ww] = word;
+            }
+        });
+}
+
+// C = A * B by parity of dot products against the transpose of B. C is a.rows x b.bits,
+// a.bits == b.rows; threads own whole rows of C, padding words included.
+template <class Kernel>
+void MatMul (const BitMatrix& a, const BitMatrix& b, BitMatrix& c, size_t threads = 1)
+{
+    const auto bt = Transpose (b);
+    ParallelFor (a.rows, threads, [&a, &bt, &c](size_t, size_t first, size_t last)
+        {
+            for (size_t ii = first; ii < last; ++ii)
+                for (size_t jw = 0; jw < c.stride; ++jw)
+                {
+                    uint64_t word = 0;
+                    const auto end = std::min (jw * 64 + 64, bt.rows);
+                    for (size_t jj = jw * 64; jj < end; ++jj)
+                        word |= uint64_t (Kernel::Dot (a.Row (ii), bt.Row (jj), a.stride)) << (jj % 64);
+                    c.data[ii * c.stride + jw] = word;
+                }
+        });
+}
+
+// A prepared for repeated y = A * x: M4R tables over the columns of A, 32 times the size of A.
+// Every byte of x picks one entry, a whole column of y, so a product is a.bits / 8 entry xors.
+template <class Kernel>
+class FourRussiansMatVec
+{
+public:
+    explicit FourRussiansMatVec (const BitMatrix& a)
+        : m_groups ((a.bits + g_k - 1) / g_k),
+          m_words (VectorWords (a.rows)),
+          m_tables (m_groups * g_combinations * m_words)
+    {
+        const auto columns = Transpose (a);
+        for (size_t gg = 0; gg < m_groups; ++gg)
+            BuildTable<Kernel> (columns, gg * g_k, 0, m_words, &m_tables[gg * g_combinations * m_words]);
+    }
+
+    // Bits of x past the columns of A are ignored; threads own whole cache lines of y
+    void Apply (const uint64_t* x, uint64_t* y, size_t threads = 1) const
+    {
+        ParallelFor (m_words / g_rowAlign, threads, [this, x, y](size_t, size_t first, size_t last)
+            {
+                ApplyLines (x, y, first * g_rowAlign, last * g_rowAlign);
+            });
+    }
+
+private:
+    void ApplyLines (const uint64_t* x, uint64_t* y, size_t first, size_t last) const noexcept
+    {
+        std::fill (y + first, y + last, 0);
+        const auto* bytes = reinterpret_cast<const uint8_t*> (x);
+        for (size_t gg = 0; gg < m_groups; ++gg)
+        {
+            const auto* entry = &m_tables[(gg * g_combinations + bytes[gg]) * m_words];
+            for (size_t ww = first; ww < last; ww += g_rowAlign)
+                Kernel::XorLine (y + ww, entry + ww);
+        }
+    }
+
+    size_t m_groups;
+    size_t m_words;
+    std::vector<uint64_t> m_tables;
+};
+
+// C = A * B by M4R over the rows of B. Work units are g_mc rows by one cache line of C: each
+// builds a 16 KB table per 8 rows of B, then adds one entry to each of its rows of C. A C
+// narrower than a line still pays for the whole line, there the parity path is ahead.
+template <class Kernel>
+void FourRussiansMatMul (const BitMatrix& a, const BitMatrix& b, BitMatrix& c, size_t threads = 1)
+{
+    const auto lines = c.stride / g_rowAlign;
+    const auto groups = (a.bits + g_k - 1) / g_k;
+    // Smaller row blocks when there are too few column lines to go around the threads
+    const auto rowsPerUnit = std::max<size_t> (1, std::min (g_mc, (a.rows * lines + threads - 1) / std::max<size_t> (1, threads)));
+    const auto rowBlocks = (a.rows + rowsPerUnit - 1) / rowsPerUnit;
+
+    ParallelFor (lines * rowBlocks, threads, [&](size_t, size_t first, size_t last)
+        {
+            std::vector<uint64_t> table (g_combinations * g_rowAlign);
+            for (auto unit = first; unit < last; ++unit)
+            {
+                const auto offset = unit % lines * g_rowAlign;
+                const auto rowFirst = unit / lines * rowsPerUnit;
+                const auto rowLast = std::min (rowFirst + rowsPerUnit, a.rows);
+
+                for (size_t ii = rowFirst; ii < rowLast; ++ii)
+                    std::fill_n (c.data.data() + ii * c.stride + offset, g_rowAlign, 0);
+
+                for (size_t gg = 0; gg < groups; ++gg)
+                {
+                    BuildTable<Kernel> (b, gg * g_k, offset, g_rowAlign, table.data());
+                    for (size_t ii = rowFirst; ii < rowLast; ++ii)
+                    {
+                        const auto byte = reinterpret_cast<const uint8_t*> (a.Row (ii))[gg];
+                        Kernel::XorLine (c.data.data() + ii * c.stride + offset, table.data() + byte * g_rowAlign);
+                    }
+                }
+            }
+        });
+}
+
+}
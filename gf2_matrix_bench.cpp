@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "gf2_matrix.h"
+#include "random_bit_matrix.h"
+
+using gf2::Avx512Kernel;
+using gf2::BitMatrix;
+using gf2::ScalarKernel;
+
+namespace
+{
+
+std::vector<uint64_t> RandomVector (size_t bits, uint32_t seed)
+{
+    const auto v = RandomMatrix (1, bits, seed);
+    return {v.data.begin(), v.data.end()};
+}
+
+}
+
+// Args: rows, columns, threads. One op is one and (or one conditional xor) per matrix bit.
+template <class Kernel, bool FourRussians>
+void BM_Gf2MatVec (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const auto a = RandomMatrix (state.range (0), state.range (1), 1);
+    const auto x = RandomVector (a.bits, 2);
+    std::vector<uint64_t> y (gf2::VectorWords (a.rows));
+    const gf2::FourRussiansMatVec<Kernel> tables (FourRussians ? a : BitMatrix (0, 0));
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        if (FourRussians)
+            tables.Apply (x.data(), y.data(), state.range (2));
+        else
+            gf2::MatVec<Kernel> (a, x.data(), y.data(), state.range (2));
+        benchmark::DoNotOptimize (y.data());
+        benchmark::ClobberMemory();
+    }
+
+    const auto ops = 1.0 * a.rows * a.bits;
+    state.counters["ops"] = benchmark::Counter (ops, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// ParallelFor starts its threads on every call. A 1024 x 1024 product takes microseconds,
+// so its threads=4 rows mostly measure thread creation; they show where splitting starts to pay.
+static void MatVecShapes (benchmark::internal::Benchmark* b)
+{
+    const int64_t shapes[][2] =
+        {
+            {1024, 1024},
+            {4096, 4096},
+            {1 << 16, 256}  // parity checks of a long code over a short message
+        };
+
+    b->ArgNames ({"rows", "cols", "threads"});
+    for (const auto& shape : shapes)
+        for (int64_t threads : {1, 4})
+            b->Args ({shape[0], shape[1], threads});
+    b->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_Gf2MatVec, ScalarKernel<AsmSolution>, false)->Apply (MatVecShapes);
+BENCHMARK_TEMPLATE(BM_Gf2MatVec, ScalarKernel<MagicSolution>, false)->Apply (MatVecShapes);
+BENCHMARK_TEMPLATE(BM_Gf2MatVec, Avx512Kernel, false)->Apply (MatVecShapes);
+BENCHMARK_TEMPLATE(BM_Gf2MatVec, ScalarKernel<AsmSolution>, true)->Apply (MatVecShapes);
+BENCHMARK_TEMPLATE(BM_Gf2MatVec, Avx512Kernel, true)->Apply (MatVecShapes);
+
+// Args: M, K, N, threads for an M x K times K x N product
+template <class Kernel, bool FourRussians>
+void BM_Gf2MatMul (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const auto a = RandomMatrix (state.range (0), state.range (1), 1);
+    const auto b = RandomMatrix (state.range (1), state.range (2), 2);
+    BitMatrix c (a.rows, b.bits);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        if (FourRussians)
+            gf2::FourRussiansMatMul<Kernel> (a, b, c, state.range (3));
+        else
+            gf2::MatMul<Kernel> (a, b, c, state.range (3));
+        benchmark::DoNotOptimize (c.data.data());
+        benchmark::ClobberMemory();
+    }
+
+    const auto ops = 1.0 * a.rows * a.bits * b.bits;
+    state.counters["ops"] = benchmark::Counter (ops, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void MatMulShapes (benchmark::internal::Benchmark* b)
+{
+    const int64_t shapes[][3] =
+        {
+            {1024, 1024, 1024},
+            {2048, 2048, 2048},
+            {1 << 16, 256, 256},
+            {1 << 16, 1024, 64}
+        };
+
+    b->ArgNames ({"M", "K", "N", "threads"});
+    for (const auto& shape : shapes)
+        for (int64_t threads : {1, 4})
+            b->Args ({shape[0], shape[1], shape[2], threads});
+    b->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_Gf2MatMul, ScalarKernel<AsmSolution>, false)->Apply (MatMulShapes);
+BENCHMARK_TEMPLATE(BM_Gf2MatMul, Avx512Kernel, false)->Apply (MatMulShapes);
+BENCHMARK_TEMPLATE(BM_Gf2MatMul, ScalarKernel<AsmSolution>, true)->Apply (MatMulShapes);
+BENCHMARK_TEMPLATE(BM_Gf2MatMul, Avx512Kernel, true)->Apply (MatMulShapes);
+
+// Every path against bit-by-bit products, on shapes leaving partial words, bytes and lines
+void BM_Gf2Check (benchmark::State &state)
+{
+    const size_t shapes[][3] = {{1, 1, 1}, {3, 5, 63}, {64, 64, 64}, {67, 130, 9}, {700, 77, 1000}, {5, 2100, 513}};
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (const auto& shape : shapes)
+        {
+            const auto a = RandomMatrix (shape[0], shape[1], 3);
+            const auto b = RandomMatrix (shape[1], shape[2], 4);
+            auto x = RandomVector (a.bits, 5);
+            // Junk past the last column must not leak into the products
+            if (a.bits % 64)
+                x[a.bits / 64] |= ~uint64_t (0) << (a.bits % 64);
+
+            std::vector<uint64_t> yEtalon (gf2::VectorWords (a.rows));
+            BitMatrix cEtalon (a.rows, b.bits);
+            for (size_t ii = 0; ii < a.rows; ++ii)
+            {
+                bool dot = false;
+                for (size_t kk = 0; kk < a.bits; ++kk)
+                    dot ^= a.Get (ii, kk) && ((x[kk / 64] >> (kk % 64)) & 1);
+                yEtalon[ii / 64] |= uint64_t (dot) << (ii % 64);
+
+                for (size_t jj = 0; jj < b.bits; ++jj)
+                {
+                    bool cell = false;
+                    for (size_t kk = 0; kk < a.bits; ++kk)
+                        cell ^= a.Get (ii, kk) && b.Get (kk, jj);
+                    if (cell)
+                        cEtalon.Set (ii, jj);
+                }
+            }
+
+            if (gf2::Transpose (gf2::Transpose (a)).data != a.data)
+                throw std::runtime_error ("test");
+
+            const auto check = [&](auto kernel, size_t threads)
+                {
+                    using Kernel = decltype (kernel);
+                    if (!Kernel::Available())
+                        return;
+
+                    std::vector<uint64_t> y (yEtalon.size(), 0x5555);
+                    gf2::MatVec<Kernel> (a, x.data(), y.data(), threads);
+                    if (y != yEtalon)
+                        throw std::runtime_error ("test");
+
+                    std::fill (y.begin(), y.end(), 0x5555);
+                    gf2::FourRussiansMatVec<Kernel> (a).Apply (x.data(), y.data(), threads);
+                    if (y != yEtalon)
+                        throw std::runtime_error ("test");
+
+                    BitMatrix c (a.rows, b.bits);
+                    std::fill (c.data.begin(), c.data.end(), 0x5555);
+                    gf2::FourRussiansMatMul<Kernel> (a, b, c, threads);
+                    if (c.data != cEtalon.data)
+                        throw std::runtime_error ("test");
+
+                    std::fill (c.data.begin(), c.data.end(), 0x5555);
+                    gf2::MatMul<Kernel> (a, b, c, threads);
+                    if (c.data != cEtalon.data)
+                        throw std::runtime_error ("test");
+                };
+
+            for (size_t threads : {1, 3})
+            {
+                check (ScalarKernel<AsmSolution> {}, threads);
+                check (ScalarKernel<MagicSolution> {}, threads);
+                check (Avx512Kernel {}, threads);
+            }
+        }
+    }
+}
+
+BENCHMARK (BM_Gf2Check);
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "mix_hash.h"
+
+// HyperLogLog distinct counter: the top `precision` bits of a key's hash pick one of
+// m = 2^precision byte registers, which keeps the largest rank, one plus the leading zero
+// count, seen among the remaining bits. Sketches merge by taking registers' maximum.
+
+namespace hll
+{
+
+struct alignas(64) Line
+{
+    uint8_t bytes[64];
+};
+
+class Sketch
+{
+public:
+    static constexpr unsigned g_minPrecision = 4;
+    static constexpr unsigned g_maxPrecision = 18;
+
+    explicit Sketch (unsigned precision)
+        : m_precision (precision),
+          m_lines (((size_t (1) << precision) + sizeof (Line) - 1) / sizeof (Line))
+    {
+        if (precision < g_minPrecision || precision > g_maxPrecision)
+            throw std::invalid_argument ("hll precision");
+    }
+
+    unsigned Precision() const noexcept
+    {
+        return m_precision;
+    }
+
+    size_t Size() const noexcept
+    {
+        return size_t (1) << m_precision;
+    }
+
+    uint8_t* Registers() noexcept
+    {
+        return m_lines.front().bytes;
+    }
+
+    const uint8_t* Registers() const noexcept
+    {
+        return m_lines.front().bytes;
+    }
+
+    template <class Kernel>
+    void Insert (const uint64_t* keys, size_t size) noexcept
+    {
+        Kernel::Insert (Registers(), m_precision, keys, size);
+    }
+
+    template <class Kernel>
+    void Merge (const Sketch* const* sources, size_t count)
+    {
+        for (size_t ii = 0; ii < count; ++ii)
+            if (sources[ii]->m_precision != m_precision)
+                throw std::invalid_argument ("hll precision mismatch");
+
+        std::vector<const uint8_t*> registers (count);
+        for (size_t ii = 0; ii < count; ++ii)
+            registers[ii] = sources[ii]->Registers();
+        Kernel::Merge (Registers(), registers.data(), count, Size());
+    }
+
+    // Raw estimate alpha * m^2 / sum(2^-register) from a histogram of the register values,
+    // switching to linear counting over the empty registers in the small range
+    double Estimate() const noexcept
+    {
+        // Four histograms, so that runs of equal registers do not serialize on one counter
+        uint32_t histograms[4][g_maxRank + 1] = {};
+        const auto* registers = Registers();
+        size_t ii = 0;
+        for (; ii + 4 <= Size(); ii += 4)
+            for (size_t jj = 0; jj < 4; ++jj)
+                ++histograms[jj][registers[ii + jj]];
+        for (; ii < Size(); ++ii)
+            ++histograms[0][registers[ii]];
+
+        double sum = 0;
+        for (int rank = g_maxRank; rank >= 0; --rank)
+        {
+            const auto count = histograms[0][rank] + histograms[1][rank] + histograms[2][rank] + histograms[3][rank];
+            sum += std::ldexp (count, -rank);
+        }
+        const auto zeros = histograms[0][0] + histograms[1][0] + histograms[2][0] + histograms[3][0];
+        return Finish (sum, zeros);
+    }
+
+    // Straight per-register sum, the baseline for Estimate()
+    double EstimateNaive() const noexcept
+    {
+        double sum = 0;
+        size_t zeros = 0;
+        for (size_t ii = 0; ii < Size(); ++ii)
+        {
+            sum += std::ldexp (1.0, -Registers()[ii]);
+            zeros += Registers()[ii] == 0;
+        }
+        return Finish (sum, zeros);
+    }
+
+    bool operator== (const Sketch& other) const noexcept
+    {
+        return m_precision == other.m_precision && std::equal (Registers(), Registers() + Size(), other.Registers());
+    }
+
+private:
+    static constexpr int g_maxRank = 64 - g_minPrecision + 1;
+
+    double Finish (double sum, size_t zeros) const noexcept
+    {
+        const double m = static_cast<double> (Size());
+        const double alpha = Size() == 16 ? 0.673 : Size() == 32 ? 0.697 : Size() == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+        const double raw = alpha * m * m / sum;
+        return raw <= 2.5 * m && zeros ? m * std::log (m / zeros) : raw;
+    }
+
+    unsigned m_precision;
+    std::vector<Line> m_lines;
+};
+
+// Registers of index `hash >> (64 - p)` take the rank of the low bits, the guard bit caps the
+// rank at 64 - p + 1 for an all-zero remainder
+inline void Update (uint8_t* registers, unsigned precision, uint64_t hash) noexcept
+{
+    const auto index = hash >> (64 - precision);
+    const auto rank = static_cast<uint8_t> (__builtin_clzll ((hash << precision) | (uint64_t (1) << (precision - 1))) + 1);
+    registers[index] = std::max (registers[index], rank);
+}
+
+struct ScalarKernel
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static void Insert (uint8_t* registers, unsigned precision, const uint64_t* keys, size_t size) noexcept
+    {
+        for (size_t ii = 0; ii < size; ++ii)
+            Update (registers, precision, MixHash (keys[ii]));
+    }
+
+    static void Merge (uint8_t* dest, const uint8_t* const* sources, size_t count, size_t size) noexcept
+    {
+        for (size_t ss = 0; ss < count; ++ss)
+            for (size_t ii = 0; ii < size; ++ii)
+                dest[ii] = std::max (dest[ii], sources[ss][ii]);
+    }
+};
+
+// Hashing, register index and rank eight keys at a time: vpmullq for the hash, vplzcntq for
+// the rank. Byte registers have no scatter, and keys of one batch may hit the same register,
+// so the max into the registers stays scalar. Merge keeps a block of the destination in
+// vector registers while every source streams past it.
+struct Avx512Kernel
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512dq") &&
+            __builtin_cpu_supports ("avx512cd") && __builtin_cpu_supports ("avx512bw");
+    }
+
+    __attribute__((target("avx512f,avx512dq,avx512cd")))
+    static void Insert (uint8_t* registers, unsigned precision, const uint64_t* keys, size_t size) noexcept
+    {
+        const auto c1 = _mm512_set1_epi64 (0xff51afd7ed558ccdULL);
+        const auto c2 = _mm512_set1_epi64 (0xc4ceb9fe1a85ec53ULL);
+        const auto guard = _mm512_set1_epi64 (uint64_t (1) << (precision - 1));
+        const auto one = _mm512_set1_epi64 (1);
+        const auto indexShift = _mm_cvtsi32_si128 (64 - precision);
+        const auto rankShift = _mm_cvtsi32_si128 (precision);
+
+        alignas(64) uint64_t indices[8];
+        alignas(64) uint64_t ranks[8];
+
+        size_t ii = 0;
+        for (; ii + 8 <= size; ii += 8)
+        {
+            auto h = _mm512_loadu_si512 (keys + ii);
+            h = _mm512_xor_si512 (h, _mm512_srli_epi64 (h, 33));
+            h = _mm512_mullo_epi64 (h, c1);
+            h = _mm512_xor_si512 (h, _mm512_srli_epi64 (h, 33));
+            h = _mm512_mullo_epi64 (h, c2);
+            h = _mm512_xor_si512 (h, _mm512_srli_epi64 (h, 33));
+
+            _mm512_store_si512 (indices, _mm512_srl_epi64 (h, indexShift));
+            _mm512_store_si512 (ranks, _mm512_add_epi64 (_mm512_lzcnt_epi64 (_mm512_or_si512 (_mm512_sll_epi64 (h, rankShift), guard)), one));
+
+            for (size_t jj = 0; jj < 8; ++jj)
+                registers[indices[jj]] = std::max (registers[indices[jj]], static_cast<uint8_t> (ranks[jj]));
+        }
+
+        ScalarKernel::Insert (registers, precision, keys + ii, size - ii);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    static void Merge (uint8_t* dest, const uint8_t* const* sources, size_t count, size_t size) noexcept
+    {
+        constexpr size_t block = 4 * 64;
+        size_t ii = 0;
+        for (; ii + block <= size; ii += block)
+        {
+            __m512i acc[4];
+            for (size_t jj = 0; jj < 4; ++jj)
+                acc[jj] = _mm512_loadu_si512 (dest + ii + jj * 64);
+
+            for (size_t ss = 0; ss < count; ++ss)
+                for (size_t jj = 0; jj < 4; ++jj)
+                    acc[jj] = _mm512_max_epu8 (acc[jj], _mm512_loadu_si512 (sources[ss] + ii + jj * 64));
+
+            for (size_t jj = 0; jj < 4; ++jj)
+                _mm512_storeu_si512 (dest + ii + jj * 64, acc[jj]);
+        }
+
+        for (size_t ss = 0; ss < count; ++ss)
+            for (size_t kk = ii; kk < size; ++kk)
+                dest[kk] = std::max (dest[kk], sources[ss][kk]);
+    }
+};
+
+}
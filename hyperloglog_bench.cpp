@@ -0,0 +1,165 @@
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "hyperloglog.h"
+
+using hll::Avx512Kernel;
+using hll::ScalarKernel;
+using hll::Sketch;
+
+namespace
+{
+
+constexpr size_t g_batch = 4096;
+constexpr size_t g_sketches = 64;
+
+#define HLL_PRECISIONS DenseRange (10, 16, 2)
+
+// Sketches of distinct overlapping key ranges, as per-partition sketches of one column are
+std::vector<std::unique_ptr<Sketch>> Partitions (unsigned precision, size_t count, size_t keys)
+{
+    std::vector<std::unique_ptr<Sketch>> res;
+    std::vector<uint64_t> batch (keys);
+    for (size_t ii = 0; ii < count; ++ii)
+    {
+        res.push_back (std::make_unique<Sketch> (precision));
+        std::iota (batch.begin(), batch.end(), ii * keys / 2);
+        res.back()->Insert<ScalarKernel> (batch.data(), batch.size());
+    }
+    return res;
+}
+
+}
+
+// Arg: precision
+template <class Kernel>
+void BM_HllInsert (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    Sketch sketch (state.range (0));
+    std::vector<uint64_t> keys (g_batch);
+    uint64_t next = 0;
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        std::iota (keys.begin(), keys.end(), next);
+        next += g_batch;
+        sketch.Insert<Kernel> (keys.data(), keys.size());
+    }
+
+    benchmark::DoNotOptimize (sketch.Registers());
+    state.SetItemsProcessed (state.iterations() * g_batch);
+}
+
+BENCHMARK_TEMPLATE(BM_HllInsert, ScalarKernel)->HLL_PRECISIONS;
+BENCHMARK_TEMPLATE(BM_HllInsert, Avx512Kernel)->HLL_PRECISIONS;
+
+// Merges g_sketches sketches into one; items are sketches merged
+template <class Kernel>
+void BM_HllMerge (benchmark::State &state)
+{
+    if (!Kernel::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const auto partitions = Partitions (state.range (0), g_sketches, 10000);
+    std::vector<const Sketch*> sources;
+    for (const auto& partition : partitions)
+        sources.push_back (partition.get());
+    Sketch total (state.range (0));
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        total.Merge<Kernel> (sources.data(), sources.size());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * g_sketches);
+    state.SetBytesProcessed (state.iterations() * g_sketches * total.Size());
+}
+
+BENCHMARK_TEMPLATE(BM_HllMerge, ScalarKernel)->HLL_PRECISIONS;
+BENCHMARK_TEMPLATE(BM_HllMerge, Avx512Kernel)->HLL_PRECISIONS;
+
+template <bool Histogram>
+void BM_HllEstimate (benchmark::State &state)
+{
+    const auto sketch = std::move (Partitions (state.range (0), 1, 1 << 20).front());
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        benchmark::DoNotOptimize (Histogram ? sketch->Estimate() : sketch->EstimateNaive());
+    }
+
+    state.SetBytesProcessed (state.iterations() * sketch->Size());
+    state.counters["error"] = sketch->Estimate() / (1 << 20) - 1;
+}
+
+BENCHMARK_TEMPLATE(BM_HllEstimate, false)->HLL_PRECISIONS;
+BENCHMARK_TEMPLATE(BM_HllEstimate, true)->HLL_PRECISIONS;
+
+#undef HLL_PRECISIONS
+
+// Kernels agree register for register, estimators agree, and the estimate is within four
+// standard errors 1.04 / sqrt(m) over small and large ranges
+void BM_HllCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (unsigned precision : {4u, 7u, 12u, 14u})
+            for (size_t distinct : {100, 5000, 1000003})
+            {
+                std::vector<uint64_t> keys (distinct);
+                std::iota (keys.begin(), keys.end(), 1 << 30);
+
+                Sketch scalar (precision), simd (precision);
+                scalar.Insert<ScalarKernel> (keys.data(), keys.size());
+                if (Avx512Kernel::Available())
+                    simd.Insert<Avx512Kernel> (keys.data(), keys.size());
+                else
+                    simd = scalar;
+
+                const auto estimate = simd.Estimate();
+                if (!(scalar == simd) || std::fabs (estimate - simd.EstimateNaive()) > 1e-6 * estimate ||
+                    std::fabs (estimate / distinct - 1) > 4 * 1.04 / std::sqrt (scalar.Size()))
+                    throw std::runtime_error ("test");
+            }
+
+        for (unsigned precision : {4u, 12u})
+        {
+            const auto partitions = Partitions (precision, 9, 3000);
+            std::vector<const Sketch*> sources;
+            for (const auto& partition : partitions)
+                sources.push_back (partition.get());
+
+            Sketch scalar (precision), simd (precision);
+            scalar.Merge<ScalarKernel> (sources.data(), sources.size());
+            if (Avx512Kernel::Available())
+                simd.Merge<Avx512Kernel> (sources.data(), sources.size());
+            else
+                simd = scalar;
+            if (!(scalar == simd))
+                throw std::runtime_error ("test");
+        }
+    }
+}
+
+BENCHMARK (BM_HllCheck);
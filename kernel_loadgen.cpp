@@ -0,0 +1,174 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "count_bits.h"
+#include "kernel_protocol.h"
+
+// Closed-loop load against a running kernel_server: every benchmark thread is a client
+// with one request in flight. The socket is $KERNEL_SERVER_SOCKET or g_defaultSocket.
+// p50/p99 are over the latencies of all clients together.
+
+namespace
+{
+
+using namespace kernel_protocol;
+
+int Connect()
+{
+    const char* path = std::getenv ("KERNEL_SERVER_SOCKET");
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strncpy (address.sun_path, path ? path : g_defaultSocket, sizeof (address.sun_path) - 1);
+
+    const int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect (fd, reinterpret_cast<sockaddr*> (&address), sizeof (address)) < 0)
+    {
+        close (fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool SendAll (int fd, const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*> (data);
+    while (size)
+    {
+        const auto sent = write (fd, bytes, size);
+        if (sent <= 0)
+            return false;
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+bool ReceiveAll (int fd, void* data, size_t size)
+{
+    auto* bytes = static_cast<uint8_t*> (data);
+    while (size)
+    {
+        const auto received = read (fd, bytes, size);
+        if (received <= 0)
+            return false;
+        bytes += received;
+        size -= received;
+    }
+    return true;
+}
+
+double Percentile (std::vector<double>& samples, double share)
+{
+    if (samples.empty())
+        return 0;
+    const auto nth = samples.begin() + static_cast<size_t> (share * (samples.size() - 1));
+    std::nth_element (samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+// Latencies of every client of the current run; the last client to finish takes the percentiles
+struct Fleet
+{
+    std::mutex mutex;
+    std::vector<double> latencies;
+    int finished = 0;
+};
+
+Fleet g_fleet;
+
+}
+
+// Args: elements per request
+void BM_ServerCount (benchmark::State &state)
+{
+    const int fd = Connect();
+    if (fd < 0)
+    {
+        state.SkipWithError ("kernel_server is not running");
+        return;
+    }
+
+    const size_t batch = state.range (0);
+    std::vector<uint32_t> request (sizeof (Header) / sizeof (uint32_t) + batch);
+    std::vector<uint32_t> response (request.size());
+
+    std::mt19937 gen(42 + state.thread_index());
+    std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
+    std::generate (request.begin() + sizeof (Header) / sizeof (uint32_t), request.end(), [&gen, &dist]() { return dist(gen); });
+
+    std::vector<uint32_t> expected (request.size());
+    std::transform (request.begin() + sizeof (Header) / sizeof (uint32_t), request.end(),
+        expected.begin() + sizeof (Header) / sizeof (uint32_t), [](uint32_t n) { return ReferenceSolution::Count (n); });
+
+    auto& header = *reinterpret_cast<Header*> (request.data());
+    header.op = PopCount;
+    header.count = batch;
+    header.id = 0;
+
+    auto& reply = *reinterpret_cast<Header*> (expected.data());
+    reply.op = Ok;
+    reply.count = batch;
+
+    // Every client is done with the previous run, and none of this one gets past the loop start until here
+    if (state.thread_index() == 0)
+    {
+        g_fleet.latencies.clear();
+        g_fleet.finished = 0;
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve (1 << 16);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        ++header.id;
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!SendAll (fd, request.data(), request.size() * sizeof (uint32_t)) ||
+            !ReceiveAll (fd, response.data(), response.size() * sizeof (uint32_t)))
+        {
+            state.SkipWithError ("connection lost");
+            break;
+        }
+        latencies.push_back (std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - start).count());
+
+        reply.id = header.id;
+        if (response != expected)
+        {
+            state.SkipWithError ("wrong response");
+            break;
+        }
+    }
+
+    close (fd);
+
+    state.SetItemsProcessed (state.iterations() * batch);
+
+    // Counters are summed over clients, so only the one reporting the fleet percentiles sets them
+    std::lock_guard<std::mutex> lock (g_fleet.mutex);
+    g_fleet.latencies.insert (g_fleet.latencies.end(), latencies.begin(), latencies.end());
+    if (++g_fleet.finished == state.threads())
+    {
+        state.counters["p50_us"] = Percentile (g_fleet.latencies, 0.5);
+        state.counters["p99_us"] = Percentile (g_fleet.latencies, 0.99);
+    }
+}
+
+BENCHMARK (BM_ServerCount)->UseRealTime()->RangeMultiplier (8)->Range (1, 32768)->ThreadRange (1, 8);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Wire format of kernel_server. A request is a header followed by `count` uint32_t values;
+// the response reuses the same layout and size, results replacing the values in place.
+namespace kernel_protocol
+{
+
+enum Op : uint32_t
+{
+    PopCount,      // results are Count (value)
+    ReverseDigits, // results are reverse (static_cast<int> (value))
+};
+
+enum Status : uint32_t
+{
+    Ok,
+    BadOp,
+};
+
+struct Header
+{
+    uint32_t op;    // Op in requests, Status in responses
+    uint32_t count;
+    uint64_t id;
+};
+
+static_assert (sizeof (Header) == 16, "the header is part of the wire format");
+
+constexpr size_t g_maxCount = 1 << 18;
+constexpr const char* g_defaultSocket = "/tmp/kernel_server.sock";
+
+}
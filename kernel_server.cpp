@@ -0,0 +1,406 @@
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "best_count.h"
+#include "kernel_protocol.h"
+#include "reverse_int.h"
+
+// Serves popcount / digit reversal over a UNIX stream socket:
+//     kernel_server [socket path] [Count solution] [reverse solution]
+// One epoll loop reads every ready connection into its own 64-byte aligned buffer and
+// runs the kernels in place on that buffer, so the response is written straight from
+// where the request landed. Requests are coalesced into one flush per batch; the batch
+// target grows while complete requests keep piling up and shrinks when the loop goes
+// idle, so a lone client is not held back waiting for a batch to fill. What a client
+// does not take right away is kept on its connection and sent on EPOLLOUT; until then
+// that connection is not read, so a client that stops reading only stalls itself.
+
+namespace
+{
+
+using namespace kernel_protocol;
+
+using CountFn = void (*) (uint32_t* data, size_t size);
+
+template <class Solution>
+void CountInPlace (uint32_t* data, size_t size)
+{
+    for (size_t ii = 0; ii < size; ++ii)
+        data[ii] = Solution::Count (data[ii]);
+}
+
+template <class Solution>
+void ReverseInPlace (uint32_t* data, size_t size)
+{
+    for (size_t ii = 0; ii < size; ++ii)
+        data[ii] = static_cast<uint32_t> (Solution::reverse (static_cast<int> (data[ii])));
+}
+
+struct Kernel
+{
+    const char* name;
+    CountFn fn;
+};
+
+const Kernel g_countKernels[] =
+{
+#define KERNEL(Solution) {#Solution, &CountInPlace<Solution>},
+    BEST_COUNT_CANDIDATES(KERNEL)
+#undef KERNEL
+};
+
+const Kernel g_reverseKernels[] =
+{
+    {"MySolution", &ReverseInPlace<reverse_int::MySolution>},
+    {"ReferenceSolution", &ReverseInPlace<reverse_int::ReferenceSolution>},
+};
+
+template <size_t Size>
+CountFn Find (const Kernel (&kernels)[Size], const char* name)
+{
+    for (const auto& kernel : kernels)
+        if (!std::strcmp (kernel.name, name))
+            return kernel.fn;
+    return nullptr;
+}
+
+constexpr size_t g_alignment = 64;
+// The first request in a buffer starts here, which puts its payload on a cache line boundary
+constexpr size_t g_headroom = g_alignment - sizeof (Header);
+constexpr size_t g_capacity = g_headroom + sizeof (Header) + g_maxCount * sizeof (uint32_t);
+
+constexpr size_t g_minBatch = 1;
+constexpr size_t g_maxBatch = 1 << 20;
+
+struct Connection
+{
+    explicit Connection (int fd_)
+        : fd (fd_),
+          buffer (static_cast<uint8_t*> (std::aligned_alloc (g_alignment, (g_capacity + g_alignment - 1) & ~(g_alignment - 1))))
+    {
+    }
+
+    ~Connection()
+    {
+        std::free (buffer);
+        close (fd);
+    }
+
+    // Bytes of complete requests at the front of the buffer, and how many elements they carry
+    size_t Complete (size_t& elements) const noexcept
+    {
+        size_t offset = g_headroom;
+        elements = 0;
+        while (end - offset >= sizeof (Header))
+        {
+            const auto header = HeaderAt (buffer + offset);
+            const auto bytes = sizeof (Header) + header.count * sizeof (uint32_t);
+            if (end - offset < bytes)
+                break;
+            offset += bytes;
+            elements += header.count;
+        }
+        return offset - g_headroom;
+    }
+
+    // Only the first request in the buffer is aligned, so headers are copied out
+    static Header HeaderAt (const uint8_t* data) noexcept
+    {
+        Header header;
+        std::memcpy (&header, data, sizeof (header));
+        return header;
+    }
+
+    int fd;
+    uint8_t* buffer;
+    size_t end = g_headroom;
+    bool queued = false;
+    std::vector<uint8_t> unsent; // response bytes waiting for EPOLLOUT
+};
+
+// Writes what the socket takes without blocking and returns how much that was, or -1 when broken.
+// MSG_NOSIGNAL turns a client gone with a response in flight into EPIPE rather than SIGPIPE.
+ssize_t WriteSome (int fd, const uint8_t* data, size_t size)
+{
+    size_t written = 0;
+    while (written < size)
+    {
+        const auto res = send (fd, data + written, size - written, MSG_NOSIGNAL);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                break;
+            return -1;
+        }
+        written += res;
+    }
+    return written;
+}
+
+class Server
+{
+public:
+    Server (const char* path, CountFn count, CountFn reverse)
+        : m_count (count),
+          m_reverse (reverse)
+    {
+        m_listen = socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::strncpy (address.sun_path, path, sizeof (address.sun_path) - 1);
+        unlink (path);
+
+        if (m_listen < 0 || bind (m_listen, reinterpret_cast<sockaddr*> (&address), sizeof (address)) < 0 || listen (m_listen, 128) < 0)
+        {
+            std::perror (path);
+            std::exit (1);
+        }
+
+        m_epoll = epoll_create1 (0);
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = m_listen;
+        if (m_epoll < 0 || epoll_ctl (m_epoll, EPOLL_CTL_ADD, m_listen, &event) < 0)
+        {
+            std::perror ("epoll");
+            std::exit (1);
+        }
+    }
+
+    [[noreturn]] void Run()
+    {
+        epoll_event events[64];
+        for (;;)
+        {
+            const int ready = epoll_wait (m_epoll, events, std::size (events), m_queue.empty() ? -1 : 0);
+            for (int ii = 0; ii < ready; ++ii)
+            {
+                if (events[ii].data.fd == m_listen)
+                    Accept();
+                else if (events[ii].events & EPOLLOUT)
+                    Write (events[ii].data.fd);
+                else
+                    Read (events[ii].data.fd);
+            }
+
+            if (m_queue.empty())
+                continue;
+
+            if (m_pending >= m_target || m_full)
+            {
+                Flush();
+                m_target = std::min (m_target * 2, g_maxBatch);
+            }
+            else if (ready <= 0)
+            {
+                Flush();
+                m_target = std::max (m_target / 2, g_minBatch);
+            }
+        }
+    }
+
+private:
+    void Accept()
+    {
+        for (;;)
+        {
+            const int fd = accept4 (m_listen, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0)
+                return;
+
+            epoll_event event {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl (m_epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+            {
+                std::perror ("epoll_ctl");
+                close (fd);
+                continue;
+            }
+            m_connections.emplace (fd, std::make_unique<Connection> (fd));
+        }
+    }
+
+    void Read (int fd)
+    {
+        const auto found = m_connections.find (fd);
+        if (found == m_connections.end())
+            return;
+
+        auto& connection = *found->second;
+        size_t before = 0;
+        const auto completeBefore = connection.Complete (before);
+
+        while (connection.end < g_capacity)
+        {
+            const auto received = read (fd, connection.buffer + connection.end, g_capacity - connection.end);
+            if (received > 0)
+            {
+                connection.end += received;
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EINTR))
+                break;
+
+            Drop (fd); // closed by the peer or broken
+            return;
+        }
+
+        size_t after = 0;
+        const auto completeAfter = connection.Complete (after);
+        if (connection.end == g_capacity)
+        {
+            if (!completeAfter)
+            {
+                Drop (fd); // request larger than g_maxCount
+                return;
+            }
+            m_full = true; // nothing more fits until this connection is answered
+        }
+
+        if (completeAfter == completeBefore)
+            return;
+
+        m_pending += after - before;
+        if (!connection.queued)
+        {
+            connection.queued = true;
+            m_queue.push_back (fd);
+        }
+    }
+
+    // Sends the rest of a response and goes back to reading once it is all out
+    void Write (int fd)
+    {
+        const auto found = m_connections.find (fd);
+        if (found == m_connections.end())
+            return;
+
+        auto& unsent = found->second->unsent;
+        const auto written = WriteSome (fd, unsent.data(), unsent.size());
+        if (written < 0)
+        {
+            Drop (fd);
+            return;
+        }
+
+        unsent.erase (unsent.begin(), unsent.begin() + written);
+        if (unsent.empty() && !Watch (fd, EPOLLIN))
+            Drop (fd);
+    }
+
+    bool Watch (int fd, uint32_t events)
+    {
+        epoll_event event {};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl (m_epoll, EPOLL_CTL_MOD, fd, &event) == 0)
+            return true;
+        std::perror ("epoll_ctl");
+        return false;
+    }
+
+    // Closing the socket takes it out of the epoll set as well, so a failed delete still drops it
+    void Drop (int fd)
+    {
+        if (epoll_ctl (m_epoll, EPOLL_CTL_DEL, fd, nullptr) < 0)
+            std::perror ("epoll_ctl");
+        m_connections.erase (fd);
+    }
+
+    // Runs every complete request in place and answers it from the same bytes
+    void Flush()
+    {
+        for (const int fd : m_queue)
+        {
+            const auto found = m_connections.find (fd);
+            if (found == m_connections.end())
+                continue;
+
+            auto& connection = *found->second;
+            connection.queued = false;
+
+            size_t elements = 0;
+            const auto bytes = connection.Complete (elements);
+            for (auto* cursor = connection.buffer + g_headroom; cursor < connection.buffer + g_headroom + bytes;)
+            {
+                auto header = Connection::HeaderAt (cursor);
+                // Payloads follow 16-byte headers and whole uint32_t arrays, so they stay 4-byte aligned
+                auto* data = reinterpret_cast<uint32_t*> (cursor + sizeof (Header));
+                if (header.op == PopCount)
+                    m_count (data, header.count);
+                else if (header.op == ReverseDigits)
+                    m_reverse (data, header.count);
+                header.op = header.op <= ReverseDigits ? Ok : BadOp;
+                std::memcpy (cursor, &header, sizeof (header));
+                cursor += sizeof (Header) + header.count * sizeof (uint32_t);
+            }
+
+            const auto* response = connection.buffer + g_headroom;
+            const auto written = WriteSome (fd, response, bytes);
+            if (written < 0)
+            {
+                Drop (fd);
+                continue;
+            }
+            if (static_cast<size_t> (written) < bytes)
+            {
+                connection.unsent.assign (response + written, response + bytes);
+                if (!Watch (fd, EPOLLOUT))
+                {
+                    Drop (fd);
+                    continue;
+                }
+            }
+
+            // Keep the partial tail request, back at the aligned position
+            const auto tail = connection.end - g_headroom - bytes;
+            std::memmove (connection.buffer + g_headroom, connection.buffer + g_headroom + bytes, tail);
+            connection.end = g_headroom + tail;
+        }
+
+        m_queue.clear();
+        m_pending = 0;
+        m_full = false;
+    }
+
+    CountFn m_count;
+    CountFn m_reverse;
+    int m_listen = -1;
+    int m_epoll = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> m_connections;
+    std::vector<int> m_queue;
+    size_t m_pending = 0; // elements in complete requests not answered yet
+    size_t m_target = 1024;
+    bool m_full = false;
+};
+
+}
+
+int main (int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : g_defaultSocket;
+    const auto count = Find (g_countKernels, argc > 2 ? argv[2] : "AsmSolution");
+    const auto reverse = Find (g_reverseKernels, argc > 3 ? argv[3] : "MySolution");
+    if (!count || !reverse)
+    {
+        std::fprintf (stderr, "usage: %s [socket] [Count solution] [reverse solution]\n", argv[0]);
+        return 1;
+    }
+
+    Server (path, count, reverse).Run();
+}
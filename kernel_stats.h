@@ -0,0 +1,278 @@
+#pragma once
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Per-thread kernel usage counters living in a POSIX shared-memory segment, so that
+// kernel_stats_scrape can read them from outside the process. Every thread owns one
+// cache line aligned slot and is its only writer, hence plain relaxed load + store
+// instead of locked read-modify-write. Slots go back to the registry when their thread
+// exits and keep their counts for the next owner. Cycles are measured on 1 call in
+// g_samplePeriod.
+// Build with -DKERNEL_STATS=0 to compile the instrumentation out.
+#ifndef KERNEL_STATS
+#define KERNEL_STATS 1
+#endif
+
+namespace kernel_stats
+{
+
+enum Kernel : uint32_t
+{
+    PopCount,
+    ReverseDigits,
+    KernelCount = 8
+};
+
+constexpr const char* g_kernelNames[KernelCount] = {"popcount", "reverse_digits"};
+
+constexpr uint64_t g_magic = 0x323053544154534B; // "KSTATS02"
+constexpr uint32_t g_maxThreads = 256;
+constexpr uint32_t g_samplePeriod = 1024;
+
+struct Counters
+{
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> elements;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> cycles;
+    std::atomic<uint64_t> samples;
+};
+
+struct alignas(64) Slot
+{
+    Counters kernels[KernelCount];
+    // Set while a thread owns the slot
+    std::atomic<bool> owned;
+    // The last slot is shared by threads that did not get one of their own
+    bool shared;
+};
+
+struct Segment
+{
+    // Written last, readers ignore the segment until it matches g_magic
+    std::atomic<uint64_t> magic;
+    uint32_t maxThreads;
+    uint32_t samplePeriod;
+    // Claims so far, including those of threads that already exited
+    std::atomic<uint32_t> claimed;
+    Slot slots[g_maxThreads];
+};
+
+inline std::string SegmentName (long pid)
+{
+    return "/kernel_stats." + std::to_string (pid);
+}
+
+// Owns the segment of this process; falls back to private memory when shm is unavailable
+class Registry
+{
+public:
+    static Registry& Instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    Slot& Claim() noexcept
+    {
+        m_segment->claimed.fetch_add (1, std::memory_order_relaxed);
+        for (uint32_t index = 0; index < g_maxThreads - 1; ++index)
+        {
+            auto& slot = m_segment->slots[index];
+            bool owned = false;
+            // Acquire pairs with Release, so the counts of the previous owner are visible
+            if (!slot.owned.load (std::memory_order_relaxed) &&
+                slot.owned.compare_exchange_strong (owned, true, std::memory_order_acquire))
+                return slot;
+        }
+        return Shared();
+    }
+
+    static void Release (Slot& slot) noexcept
+    {
+        if (!slot.shared)
+            slot.owned.store (false, std::memory_order_release);
+    }
+
+    Slot& Shared() noexcept
+    {
+        return m_segment->slots[g_maxThreads - 1];
+    }
+
+    const std::string& Name() const noexcept
+    {
+        return m_name;
+    }
+
+private:
+    Registry()
+        : m_creator (getpid()),
+          m_name (SegmentName (m_creator))
+    {
+        void* memory = MAP_FAILED;
+        const int fd = shm_open (m_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (fd >= 0)
+        {
+            if (ftruncate (fd, sizeof (Segment)) == 0)
+                memory = mmap (nullptr, sizeof (Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close (fd);
+        }
+
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink (m_name.c_str());
+            m_name.clear();
+            memory = mmap (nullptr, sizeof (Segment), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED)
+                throw std::bad_alloc();
+        }
+
+        // Fresh mappings are zero filled, which is a valid state for every counter
+        m_segment = static_cast<Segment*> (memory);
+        m_segment->maxThreads = g_maxThreads;
+        m_segment->samplePeriod = g_samplePeriod;
+        m_segment->slots[g_maxThreads - 1].shared = true;
+        m_segment->magic.store (g_magic, std::memory_order_release);
+
+        pthread_atfork (nullptr, nullptr, &AfterFork);
+    }
+
+    // The mapping stays: threads still running during static destruction may write to it.
+    // A forked child leaving through exit() runs this too, and must not unlink its parent's
+    // segment.
+    ~Registry()
+    {
+        if (!m_name.empty() && getpid() == m_creator)
+            shm_unlink (m_name.c_str());
+    }
+
+    static void AfterFork() noexcept;
+
+    pid_t m_creator;
+    std::string m_name;
+    Segment* m_segment = nullptr;
+};
+
+struct ThreadState
+{
+    Slot* slot = nullptr;
+    uint32_t tick = 0;
+};
+
+inline thread_local ThreadState t_state;
+
+// Hands the slot of its thread back to the registry on thread exit
+struct SlotLease
+{
+    ~SlotLease()
+    {
+        if (t_state.slot)
+            Registry::Release (*t_state.slot);
+        t_state.slot = nullptr;
+    }
+};
+
+// A forked child would keep writing to its parent thread's slot. It moves to the shared slot
+// instead: children often leave through _exit, which would never give a claimed slot back.
+inline void Registry::AfterFork() noexcept
+{
+    if (t_state.slot)
+        t_state.slot = &Instance().Shared();
+}
+
+inline Slot& ClaimSlot() noexcept
+{
+    static thread_local SlotLease lease;
+    static_cast<void> (lease);
+    return Registry::Instance().Claim();
+}
+
+inline void Add (const Slot& slot, std::atomic<uint64_t>& counter, uint64_t value) noexcept
+{
+    if (slot.shared)
+        counter.fetch_add (value, std::memory_order_relaxed);
+    else
+        counter.store (counter.load (std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Accounts one kernel call of `elements` items spanning `bytes`
+class Scope
+{
+public:
+    Scope (Kernel kernel, uint64_t elements, uint64_t bytes) noexcept
+#if KERNEL_STATS
+    {
+        auto& state = t_state;
+        if (!state.slot)
+            state.slot = &ClaimSlot();
+
+        m_slot = state.slot;
+        m_counters = &m_slot->kernels[kernel];
+        Add (*m_slot, m_counters->calls, 1);
+        Add (*m_slot, m_counters->elements, elements);
+        Add (*m_slot, m_counters->bytes, bytes);
+
+        if (__builtin_expect (++state.tick == g_samplePeriod, 0))
+        {
+            state.tick = 0;
+            m_start = __rdtsc();
+        }
+    }
+#else
+    {
+        static_cast<void> (kernel);
+        static_cast<void> (elements);
+        static_cast<void> (bytes);
+    }
+#endif
+
+    Scope (const Scope&) = delete;
+    Scope& operator= (const Scope&) = delete;
+
+#if KERNEL_STATS
+    ~Scope()
+    {
+        if (__builtin_expect (m_start != 0, 0))
+        {
+            Add (*m_slot, m_counters->cycles, __rdtsc() - m_start);
+            Add (*m_slot, m_counters->samples, 1);
+        }
+    }
+
+private:
+    Slot* m_slot;
+    Counters* m_counters;
+    uint64_t m_start = 0;
+#endif
+};
+
+// Solution wrapper accounting every Count / reverse call
+template <class Solution>
+struct Instrumented
+{
+    template <class S = Solution>
+    static auto Count (uint32_t n) noexcept -> decltype (S::Count (n))
+    {
+        Scope scope (PopCount, 1, sizeof (n));
+        return Solution::Count (n);
+    }
+
+    template <class S = Solution>
+    static auto reverse (int x) -> decltype (S::reverse (x))
+    {
+        Scope scope (ReverseDigits, 1, sizeof (x));
+        return Solution::reverse (x);
+    }
+};
+
+}
@@ -0,0 +1,63 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "kernel_stats.h"
+
+// Prints the kernel usage counters of a running process: kernel_stats_scrape <pid>
+
+int main (int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::fprintf (stderr, "usage: %s <pid>\n", argv[0]);
+        return 1;
+    }
+
+    using namespace kernel_stats;
+
+    const auto name = SegmentName (std::atol (argv[1]));
+    const int fd = shm_open (name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        std::perror (name.c_str());
+        return 1;
+    }
+
+    const auto* segment = static_cast<const Segment*> (mmap (nullptr, sizeof (Segment), PROT_READ, MAP_SHARED, fd, 0));
+    close (fd);
+    if (segment == MAP_FAILED || segment->magic.load (std::memory_order_acquire) != g_magic)
+    {
+        std::fprintf (stderr, "%s is not a kernel_stats segment\n", name.c_str());
+        return 1;
+    }
+
+    std::printf ("%u threads so far, cycles sampled 1 in %u calls\n",
+        segment->claimed.load (std::memory_order_relaxed), segment->samplePeriod);
+    std::printf ("%-16s %16s %16s %16s %14s\n", "kernel", "calls", "elements", "bytes", "cycles/call");
+
+    for (uint32_t kernel = 0; kernel < KernelCount; ++kernel)
+    {
+        uint64_t calls = 0, elements = 0, bytes = 0, cycles = 0, samples = 0;
+        for (uint32_t thread = 0; thread < segment->maxThreads; ++thread)
+        {
+            const auto& counters = segment->slots[thread].kernels[kernel];
+            calls += counters.calls.load (std::memory_order_relaxed);
+            elements += counters.elements.load (std::memory_order_relaxed);
+            bytes += counters.bytes.load (std::memory_order_relaxed);
+            cycles += counters.cycles.load (std::memory_order_relaxed);
+            samples += counters.samples.load (std::memory_order_relaxed);
+        }
+
+        if (!calls)
+            continue;
+
+        std::printf ("%-16s %16lu %16lu %16lu %14.1f\n", g_kernelNames[kernel] ? g_kernelNames[kernel] : "?",
+            calls, elements, bytes, samples ? static_cast<double> (cycles) / samples : 0.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "best_count.h"
+#include "count_bits.h"
+#include "reverse_int.h"
+
+// Stable entry points of the header-only `kernels` library. Signatures and semantics here
+// only change together with g_apiVersion; the Solution types behind them may change freely.
+// Everything is always_inline so that a call from a service's translation unit costs the
+// same as the benchmarks' direct Solution::Count calls.
+namespace kernels
+{
+
+constexpr int g_apiVersion = 1;
+
+// Number of set bits in n
+__attribute__((always_inline))
+inline uint32_t PopCount (uint32_t n) noexcept
+{
+    return AsmSolution::Count (n);
+}
+
+// Number of set bits in data[0, size)
+__attribute__((always_inline))
+inline uint64_t PopCountBulk (const uint32_t* data, size_t size) noexcept
+{
+    return BestCount::CountBulk (data, size);
+}
+
+// Decimal digits of x reversed keeping the sign, 0 when the result overflows int
+__attribute__((always_inline))
+inline int ReverseDigits (int x) noexcept
+{
+    return reverse_int::MySolution::reverse (x);
+}
+
+}
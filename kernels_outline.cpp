@@ -0,0 +1,25 @@
+#include "kernels.h"
+
+// The kernels API behind a translation unit boundary. Built twice, as KERNELS_OUTLINE_NS
+// `outline` with plain object code and as `outline_lto` with LTO bytecode, so that
+// cross_tu_bench shows what the boundary costs and how much LTO wins back.
+
+namespace KERNELS_OUTLINE_NS
+{
+
+uint32_t PopCount (uint32_t n) noexcept
+{
+    return kernels::PopCount (n);
+}
+
+uint64_t PopCountBulk (const uint32_t* data, size_t size) noexcept
+{
+    return kernels::PopCountBulk (data, size);
+}
+
+int ReverseDigits (int x) noexcept
+{
+    return kernels::ReverseDigits (x);
+}
+
+}
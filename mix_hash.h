@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Finalizer of MurmurHash3: every input bit affects every output bit, cheap enough to
+// hash integer keys one by one
+inline uint64_t MixHash (uint64_t key) noexcept
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
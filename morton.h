@@ -0,0 +1,355 @@
+#pragma once
+
+#include <cpuid.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Morton (Z-order) codes of 2D and 3D points: bit i of coordinate d lands at bit i * Dims + d
+// of the code. A Code of 32 or 64 bits holds sizeof (Code) * 8 / Dims bits per coordinate,
+// coordinates must fit that width. Points are Dims consecutive uint32_t coordinates.
+
+template <unsigned Dims, class Code>
+constexpr unsigned g_mortonBits = sizeof (Code) * 8 / Dims;
+
+// Bits of coordinate 0 in the code; coordinate d uses it shifted left by d
+template <unsigned Dims, class Code>
+constexpr Code MortonMask() noexcept
+{
+    Code res = 0;
+    for (unsigned ii = 0; ii < g_mortonBits<Dims, Code>; ++ii)
+        res |= Code (1) << (ii * Dims);
+    return res;
+}
+
+struct ReferenceMortonSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    template <unsigned Dims, class Code>
+    static Code Encode (const uint32_t* point) noexcept
+    {
+        Code res = 0;
+        for (unsigned ii = 0; ii < g_mortonBits<Dims, Code>; ++ii)
+            for (unsigned dd = 0; dd < Dims; ++dd)
+                res |= static_cast<Code> ((point[dd] >> ii) & 1) << (ii * Dims + dd);
+        return res;
+    }
+
+    template <unsigned Dims, class Code>
+    static void Decode (Code code, uint32_t* point) noexcept
+    {
+        for (unsigned dd = 0; dd < Dims; ++dd)
+        {
+            point[dd] = 0;
+            for (unsigned ii = 0; ii < g_mortonBits<Dims, Code>; ++ii)
+                point[dd] |= static_cast<uint32_t> ((code >> (ii * Dims + dd)) & 1) << ii;
+        }
+    }
+};
+
+// Spreads a coordinate by shifting it onto itself at halving distances, masking off the copies
+// at every step, as MagicSolution sums bit fields; compacting runs the steps backwards
+struct MagicMortonSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    template <unsigned Dims, class Code>
+    static Code Encode (const uint32_t* point) noexcept
+    {
+        Code res = 0;
+        for (unsigned dd = 0; dd < Dims; ++dd)
+            res |= Spread<Dims, Code> (point[dd]) << dd;
+        return res;
+    }
+
+    template <unsigned Dims, class Code>
+    static void Decode (Code code, uint32_t* point) noexcept
+    {
+        for (unsigned dd = 0; dd < Dims; ++dd)
+            point[dd] = Compact<Dims, Code> (code >> dd);
+    }
+
+private:
+    template <unsigned Dims, class Code>
+    static Code Spread (uint32_t c) noexcept
+    {
+        if constexpr (Dims == 2 && sizeof (Code) == 4)
+        {
+            uint32_t v = c & 0xFFFF;
+            v = (v | (v << 8)) & 0x00FF00FF;
+            v = (v | (v << 4)) & 0x0F0F0F0F;
+            v = (v | (v << 2)) & 0x33333333;
+            return (v | (v << 1)) & 0x55555555;
+        }
+        else if constexpr (Dims == 2)
+        {
+            uint64_t v = c;
+            v = (v | (v << 16)) & 0x0000FFFF0000FFFF;
+            v = (v | (v << 8)) & 0x00FF00FF00FF00FF;
+            v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0F;
+            v = (v | (v << 2)) & 0x3333333333333333;
+            return (v | (v << 1)) & 0x5555555555555555;
+        }
+        else if constexpr (sizeof (Code) == 4)
+        {
+            uint32_t v = c & 0x3FF;
+            v = (v | (v << 16)) & 0x030000FF;
+            v = (v | (v << 8)) & 0x0300F00F;
+            v = (v | (v << 4)) & 0x030C30C3;
+            return (v | (v << 2)) & 0x09249249;
+        }
+        else
+        {
+            uint64_t v = c & 0x1FFFFF;
+            v = (v | (v << 32)) & 0x001F00000000FFFF;
+            v = (v | (v << 16)) & 0x001F0000FF0000FF;
+            v = (v | (v << 8)) & 0x100F00F00F00F00F;
+            v = (v | (v << 4)) & 0x10C30C30C30C30C3;
+            return (v | (v << 2)) & 0x1249249249249249;
+        }
+    }
+
+    template <unsigned Dims, class Code>
+    static uint32_t Compact (Code v) noexcept
+    {
+        if constexpr (Dims == 2 && sizeof (Code) == 4)
+        {
+            v &= 0x55555555;
+            v = (v | (v >> 1)) & 0x33333333;
+            v = (v | (v >> 2)) & 0x0F0F0F0F;
+            v = (v | (v >> 4)) & 0x00FF00FF;
+            return (v | (v >> 8)) & 0x0000FFFF;
+        }
+        else if constexpr (Dims == 2)
+        {
+            v &= 0x5555555555555555;
+            v = (v | (v >> 1)) & 0x3333333333333333;
+            v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0F;
+            v = (v | (v >> 4)) & 0x00FF00FF00FF00FF;
+            v = (v | (v >> 8)) & 0x0000FFFF0000FFFF;
+            return static_cast<uint32_t> ((v | (v >> 16)) & 0x00000000FFFFFFFF);
+        }
+        else if constexpr (sizeof (Code) == 4)
+        {
+            v &= 0x09249249;
+            v = (v | (v >> 2)) & 0x030C30C3;
+            v = (v | (v >> 4)) & 0x0300F00F;
+            v = (v | (v >> 8)) & 0x030000FF;
+            return (v | (v >> 16)) & 0x000003FF;
+        }
+        else
+        {
+            v &= 0x1249249249249249;
+            v = (v | (v >> 2)) & 0x10C30C30C30C30C3;
+            v = (v | (v >> 4)) & 0x100F00F00F00F00F;
+            v = (v | (v >> 8)) & 0x001F0000FF0000FF;
+            v = (v | (v >> 16)) & 0x001F00000000FFFF;
+            return static_cast<uint32_t> ((v | (v >> 32)) & 0x00000000001FFFFF);
+        }
+    }
+};
+
+// Encode: each coordinate byte through a table of its bits spread Dims apart. Decode: chunks
+// of Dims * K code bits through a table of the K bits each coordinate holds there, K = 4 in
+// 2D (256 entries) and 3 in 3D (512 entries).
+template <unsigned Dims>
+constexpr static auto MortonSpreadTable() noexcept
+{
+    std::array<uint32_t, 256> res = {0,};
+    for (uint32_t ii = 0; ii < res.size(); ++ii)
+        for (uint32_t bit = 0; bit < 8; ++bit)
+            res[ii] |= ((ii >> bit) & 1) << (bit * Dims);
+    return res;
+}
+
+template <unsigned Dims>
+constexpr static auto MortonCompactTable() noexcept
+{
+    constexpr unsigned k = Dims == 2 ? 4 : 3;
+    std::array<uint16_t, 1 << (Dims * k)> res = {0,};
+    for (uint32_t ii = 0; ii < res.size(); ++ii)
+        for (uint32_t bit = 0; bit < Dims * k; ++bit)
+            res[ii] |= ((ii >> bit) & 1) << ((bit % Dims) * k + bit / Dims);
+    return res;
+}
+
+struct TableMortonSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    template <unsigned Dims, class Code>
+    static Code Encode (const uint32_t* point) noexcept
+    {
+        constexpr unsigned bytes = (g_mortonBits<Dims, Code> + 7) / 8;
+        const auto& table = Dims == 2 ? g_spread2 : g_spread3;
+
+        Code res = 0;
+        for (unsigned dd = 0; dd < Dims; ++dd)
+            for (unsigned bb = 0; bb < bytes; ++bb)
+                res |= static_cast<Code> (table[(point[dd] >> (bb * 8)) & 0xFF]) << (bb * 8 * Dims + dd);
+        return res;
+    }
+
+    template <unsigned Dims, class Code>
+    static void Decode (Code code, uint32_t* point) noexcept
+    {
+        constexpr unsigned k = Dims == 2 ? 4 : 3;
+        constexpr unsigned chunks = (g_mortonBits<Dims, Code> + k - 1) / k;
+        constexpr Code chunkMask = (Code (1) << (Dims * k)) - 1;
+
+        uint32_t coords[Dims] = {};
+        for (unsigned cc = 0; cc < chunks; ++cc)
+        {
+            const auto chunk = static_cast<size_t> ((code >> (cc * Dims * k)) & chunkMask);
+            uint32_t entry;
+            if constexpr (Dims == 2)
+                entry = g_compact2[chunk];
+            else
+                entry = g_compact3[chunk];
+            for (unsigned dd = 0; dd < Dims; ++dd)
+                coords[dd] |= ((entry >> (dd * k)) & ((1u << k) - 1)) << (cc * k);
+        }
+
+        // The last chunk may reach past the code's coordinate bits
+        constexpr auto coordMask = static_cast<uint32_t> ((uint64_t (1) << g_mortonBits<Dims, Code>) - 1);
+        for (unsigned dd = 0; dd < Dims; ++dd)
+            point[dd] = coords[dd] & coordMask;
+    }
+
+private:
+    constexpr static auto g_spread2 = MortonSpreadTable<2>();
+    constexpr static auto g_spread3 = MortonSpreadTable<3>();
+    inline const static auto g_compact2 = MortonCompactTable<2>();
+    inline const static auto g_compact3 = MortonCompactTable<3>();
+};
+
+// pdep scatters a coordinate onto its mask, pext gathers it back. Spelled in asm to keep
+// -mbmi2 away from every includer.
+struct PdepMortonSolution
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("bmi2");
+    }
+
+    template <unsigned Dims, class Code>
+    static Code Encode (const uint32_t* point) noexcept
+    {
+        constexpr uint64_t mask = MortonMask<Dims, Code>();
+        uint64_t res = 0;
+        for (unsigned dd = 0; dd < Dims; ++dd)
+        {
+            uint64_t spread;
+            asm ("pdep %2, %1, %0" : "=r" (spread) : "r" (uint64_t (point[dd])), "r" (mask << dd));
+            res |= spread;
+        }
+        return static_cast<Code> (res);
+    }
+
+    template <unsigned Dims, class Code>
+    static void Decode (Code code, uint32_t* point) noexcept
+    {
+        constexpr uint64_t mask = MortonMask<Dims, Code>();
+        for (unsigned dd = 0; dd < Dims; ++dd)
+        {
+            uint64_t coord;
+            asm ("pext %2, %1, %0" : "=r" (coord) : "r" (uint64_t (code)), "r" (mask << dd));
+            point[dd] = static_cast<uint32_t> (coord);
+        }
+    }
+};
+
+// "HygonGenuine", which older <cpuid.h> do not define
+constexpr unsigned g_hygonEbx = 0x6f677948;
+constexpr unsigned g_hygonEdx = 0x6e65476e;
+constexpr unsigned g_hygonEcx = 0x656e6975;
+
+// AMD implemented pdep / pext in microcode until Zen 3 (family 19h), at a latency growing
+// with the mask's popcount, slower there than the magic masks. Hygon Dhyana (family 18h)
+// is Zen 1 and has the same microcode.
+inline bool FastPdep() noexcept
+{
+    static const bool fast = []()
+        {
+            if (!PdepMortonSolution::Available())
+                return false;
+
+            unsigned eax, ebx, ecx, edx;
+            if (!__get_cpuid (0, &eax, &ebx, &ecx, &edx))
+                return false;
+            const bool amd = ebx == signature_AMD_ebx && ecx == signature_AMD_ecx && edx == signature_AMD_edx;
+            const bool hygon = ebx == g_hygonEbx && ecx == g_hygonEcx && edx == g_hygonEdx;
+            if (!amd && !hygon)
+                return true;
+
+            __get_cpuid (1, &eax, &ebx, &ecx, &edx);
+            const unsigned baseFamily = (eax >> 8) & 0xF;
+            const unsigned family = baseFamily == 0xF ? baseFamily + ((eax >> 20) & 0xFF) : baseFamily;
+            return family >= 0x19;
+        }();
+    return fast;
+}
+
+// pdep / pext where they are fast, the magic masks otherwise; the bulk forms decide once
+struct BestMortonSolution
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    template <unsigned Dims, class Code>
+    static Code Encode (const uint32_t* point) noexcept
+    {
+        return FastPdep() ? PdepMortonSolution::Encode<Dims, Code> (point) : MagicMortonSolution::Encode<Dims, Code> (point);
+    }
+
+    template <unsigned Dims, class Code>
+    static void Decode (Code code, uint32_t* point) noexcept
+    {
+        FastPdep() ? PdepMortonSolution::Decode<Dims> (code, point) : MagicMortonSolution::Decode<Dims> (code, point);
+    }
+};
+
+template <class Solution, unsigned Dims, class Code>
+struct MortonBulk
+{
+    static void Encode (const uint32_t* points, Code* codes, size_t size) noexcept
+    {
+        for (size_t ii = 0; ii < size; ++ii)
+            codes[ii] = Solution::template Encode<Dims, Code> (points + ii * Dims);
+    }
+
+    static void Decode (const Code* codes, uint32_t* points, size_t size) noexcept
+    {
+        for (size_t ii = 0; ii < size; ++ii)
+            Solution::template Decode<Dims> (codes[ii], points + ii * Dims);
+    }
+};
+
+template <unsigned Dims, class Code>
+struct MortonBulk<BestMortonSolution, Dims, Code>
+{
+    static void Encode (const uint32_t* points, Code* codes, size_t size) noexcept
+    {
+        FastPdep() ? MortonBulk<PdepMortonSolution, Dims, Code>::Encode (points, codes, size) :
+            MortonBulk<MagicMortonSolution, Dims, Code>::Encode (points, codes, size);
+    }
+
+    static void Decode (const Code* codes, uint32_t* points, size_t size) noexcept
+    {
+        FastPdep() ? MortonBulk<PdepMortonSolution, Dims, Code>::Decode (codes, points, size) :
+            MortonBulk<MagicMortonSolution, Dims, Code>::Decode (codes, points, size);
+    }
+};
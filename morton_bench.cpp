@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "morton.h"
+
+namespace
+{
+
+constexpr size_t g_points = 1 << 16;
+
+template <unsigned Dims, class Code>
+std::vector<uint32_t> GeneratePoints (size_t size, uint32_t seed = 42)
+{
+    std::mt19937 gen(seed);
+    std::vector<uint32_t> res (size * Dims);
+    for (auto& coord : res)
+        coord = static_cast<uint32_t> (gen() & ((uint64_t (1) << g_mortonBits<Dims, Code>) - 1));
+    return res;
+}
+
+}
+
+template <class Solution, unsigned Dims, class Code>
+void BM_MortonEncode (benchmark::State &state)
+{
+    if (!Solution::Available())
+    {
+        state.SkipWithError ("solution not supported by this cpu");
+        return;
+    }
+
+    const auto points = GeneratePoints<Dims, Code> (g_points);
+    std::vector<Code> codes (g_points);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        MortonBulk<Solution, Dims, Code>::Encode (points.data(), codes.data(), g_points);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * g_points);
+}
+
+template <class Solution, unsigned Dims, class Code>
+void BM_MortonDecode (benchmark::State &state)
+{
+    if (!Solution::Available())
+    {
+        state.SkipWithError ("solution not supported by this cpu");
+        return;
+    }
+
+    std::vector<Code> codes (g_points);
+    MortonBulk<ReferenceMortonSolution, Dims, Code>::Encode (GeneratePoints<Dims, Code> (g_points).data(), codes.data(), g_points);
+    std::vector<uint32_t> points (g_points * Dims);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        MortonBulk<Solution, Dims, Code>::Decode (codes.data(), points.data(), g_points);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * g_points);
+}
+
+#define MORTON(Solution) \
+    BENCHMARK_TEMPLATE(BM_MortonEncode, Solution, 2, uint32_t); \
+    BENCHMARK_TEMPLATE(BM_MortonEncode, Solution, 2, uint64_t); \
+    BENCHMARK_TEMPLATE(BM_MortonEncode, Solution, 3, uint32_t); \
+    BENCHMARK_TEMPLATE(BM_MortonEncode, Solution, 3, uint64_t); \
+    BENCHMARK_TEMPLATE(BM_MortonDecode, Solution, 2, uint32_t); \
+    BENCHMARK_TEMPLATE(BM_MortonDecode, Solution, 2, uint64_t); \
+    BENCHMARK_TEMPLATE(BM_MortonDecode, Solution, 3, uint32_t); \
+    BENCHMARK_TEMPLATE(BM_MortonDecode, Solution, 3, uint64_t);
+
+MORTON(ReferenceMortonSolution)
+MORTON(MagicMortonSolution)
+MORTON(TableMortonSolution)
+MORTON(PdepMortonSolution)
+MORTON(BestMortonSolution)
+
+#undef MORTON
+
+namespace
+{
+
+// Decodes every code in [first, last) with each solution against the magic masks and encodes
+// the points back; the magic masks are checked against the bit loop on a stride
+template <unsigned Dims, class Code>
+void CheckCodes (uint64_t first, uint64_t last)
+{
+    constexpr size_t chunk = 1 << 16;
+    std::vector<Code> codes (chunk), back (chunk);
+    std::vector<uint32_t> etalon (chunk * Dims), points (chunk * Dims);
+
+    const auto check = [&](auto solution, size_t n)
+        {
+            using Solution = decltype (solution);
+            if (!Solution::Available())
+                return;
+            MortonBulk<Solution, Dims, Code>::Decode (codes.data(), points.data(), n);
+            MortonBulk<Solution, Dims, Code>::Encode (points.data(), back.data(), n);
+            if (!std::equal (etalon.begin(), etalon.begin() + n * Dims, points.begin()) ||
+                !std::equal (codes.begin(), codes.begin() + n, back.begin()))
+                throw std::runtime_error ("test");
+        };
+
+    for (auto begin = first; begin < last; begin += chunk)
+    {
+        const auto n = static_cast<size_t> (std::min<uint64_t> (chunk, last - begin));
+        std::iota (codes.begin(), codes.begin() + n, static_cast<Code> (begin));
+        MortonBulk<MagicMortonSolution, Dims, Code>::Decode (codes.data(), etalon.data(), n);
+
+        uint32_t reference[Dims];
+        const auto probe = (begin / chunk) % n;
+        ReferenceMortonSolution::Decode<Dims> (codes[probe], reference);
+        if (!std::equal (reference, reference + Dims, etalon.begin() + probe * Dims))
+            throw std::runtime_error ("test");
+
+        check (TableMortonSolution {}, n);
+        check (PdepMortonSolution {}, n);
+        check (BestMortonSolution {}, n);
+        check (MagicMortonSolution {}, n);
+    }
+}
+
+}
+
+// Every 32-bit 2D code and every 30-bit 3D code; 64-bit codes by random points
+void BM_MortonCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        CheckCodes<2, uint32_t> (0, uint64_t (1) << 32);
+        CheckCodes<3, uint32_t> (0, uint64_t (1) << 30);
+
+        const auto check64 = [](auto dims)
+            {
+                constexpr unsigned Dims = decltype (dims)::value;
+                const auto points = GeneratePoints<Dims, uint64_t> (100000, 3);
+                std::vector<uint64_t> etalon (100000), codes (100000);
+                MortonBulk<ReferenceMortonSolution, Dims, uint64_t>::Encode (points.data(), etalon.data(), etalon.size());
+
+                const auto check = [&](auto solution)
+                    {
+                        using Solution = decltype (solution);
+                        if (!Solution::Available())
+                            return;
+                        MortonBulk<Solution, Dims, uint64_t>::Encode (points.data(), codes.data(), codes.size());
+                        if (codes != etalon)
+                            throw std::runtime_error ("test");
+                    };
+                check (MagicMortonSolution {});
+                check (TableMortonSolution {});
+                check (PdepMortonSolution {});
+                check (BestMortonSolution {});
+                CheckCodes<Dims, uint64_t> (0, 1 << 20);
+            };
+        check64 (std::integral_constant<unsigned, 2> {});
+        check64 (std::integral_constant<unsigned, 3> {});
+    }
+}
+
+BENCHMARK (BM_MortonCheck)->Iterations (1)->Unit (benchmark::kSecond);
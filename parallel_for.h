@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Runs body (thread, first, last) over [0, units) split into at most `threads` contiguous
+// ranges, the first on the calling thread. Threads are started per call, so a call has to
+// carry well over the cost of a thread start for the split to pay off.
+template <class Body>
+void ParallelFor (size_t units, size_t threads, const Body& body)
+{
+    threads = std::max<size_t> (1, std::min (threads, units));
+    const auto perThread = (units + threads - 1) / threads;
+
+    std::vector<std::thread> workers;
+    for (size_t tt = 1; tt < threads; ++tt)
+    {
+        const auto first = std::min (tt * perThread, units);
+        const auto last = std::min (first + perThread, units);
+        workers.emplace_back ([&body, tt, first, last]() { body (tt, first, last); });
+    }
+
+    body (0, 0, std::min (perThread, units));
+    for (auto& worker : workers)
+        worker.join();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "binary_gemm.h"
+
+// Bit matrix of fair coin flips for the binary_gemm and gf2_matrix benchmarks; the padding
+// past the last column stays zero
+inline binary_gemm::BitMatrix RandomMatrix (size_t rows, size_t bits, uint32_t seed)
+{
+    binary_gemm::BitMatrix res (rows, bits);
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution dist(0.5);
+    for (size_t ii = 0; ii < rows; ++ii)
+        for (size_t bit = 0; bit < bits; ++bit)
+            if (dist(gen))
+                res.Set (ii, bit);
+    return res;
+}
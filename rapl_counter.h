@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <benchmark/benchmark.h>
+
+// Package and DRAM energy read from the Linux powercap RAPL interface.
+// Counters are machine-wide, so anything else running on the host is billed too.
+class RaplCounter
+{
+public:
+    RaplCounter()
+    {
+        namespace fs = std::filesystem;
+
+        std::error_code ec;
+        for (const auto& zone : fs::directory_iterator (g_root, ec))
+        {
+            const auto zoneName = zone.path().filename().string();
+            if (zoneName.rfind ("intel-rapl:", 0) != 0 || zoneName.find (':', 11) != std::string::npos)
+                continue;
+
+            if (ReadName (zone.path()).rfind ("package", 0) == 0)
+                AddDomain (zone.path());
+
+            for (const auto& sub : fs::directory_iterator (zone.path(), ec))
+                if (sub.path().filename().string().rfind (zoneName + ":", 0) == 0 && ReadName (sub.path()) == "dram")
+                    AddDomain (sub.path());
+        }
+    }
+
+    bool Available() const noexcept
+    {
+        return !m_domains.empty();
+    }
+
+    void Start()
+    {
+        for (auto& domain : m_domains)
+            domain.start = ReadUint (domain.energy);
+    }
+
+    // Microjoules consumed since Start(), summed over all domains
+    double Stop() const
+    {
+        double res = 0;
+        for (const auto& domain : m_domains)
+        {
+            const auto now = ReadUint (domain.energy);
+            res += now >= domain.start ? now - domain.start : domain.range - domain.start + now;
+        }
+        return res;
+    }
+
+private:
+    struct Domain
+    {
+        std::string energy;
+        uint64_t range;
+        uint64_t start;
+    };
+
+    static std::string ReadName (const std::filesystem::path& zone)
+    {
+        std::ifstream in (zone / "name");
+        std::string res;
+        in >> res;
+        return res;
+    }
+
+    static uint64_t ReadUint (const std::string& path)
+    {
+        std::ifstream in (path);
+        uint64_t res = 0;
+        in >> res;
+        return res;
+    }
+
+    void AddDomain (const std::filesystem::path& zone)
+    {
+        // energy_uj is root-only on recent kernels, so probe it before relying on it
+        std::ifstream in (zone / "energy_uj");
+        uint64_t probe = 0;
+        if (!(in >> probe))
+            return;
+
+        m_domains.push_back ({(zone / "energy_uj").string(), ReadUint ((zone / "max_energy_range_uj").string()), probe});
+    }
+
+    inline static const char* g_root = "/sys/class/powercap";
+
+    std::vector<Domain> m_domains;
+};
+
+inline void SetEnergyCounters (benchmark::State &state, const RaplCounter& rapl)
+{
+    const auto microJoules = rapl.Stop();
+    if (state.items_processed())
+        state.counters["nJ_per_item"] = microJoules * 1000 / state.items_processed();
+    state.counters["Watts"] = benchmark::Counter (microJoules / 1'000'000, benchmark::Counter::kIsRate);
+}
@@ -0,0 +1,217 @@
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "count_bits.h"
+#include "count_bits_avx2.h"
+#include "reverse_int.h"
+
+// Count / reverse applied to some fields of a record stream laid out as array-of-structs,
+// struct-of-arrays and AoSoA tiles. Records are Fields x uint32_t; the argument is how many
+// fields are touched. line_use is the share of every loaded cache line the kernel reads.
+
+namespace
+{
+
+constexpr size_t g_records = 1 << 20;
+constexpr size_t g_tile = 16; // records per AoSoA tile, one cache line per field
+
+// Ops see the longest contiguous run a layout offers: the touched fields of one record for
+// AoS, one whole column for SoA, one field of a tile for AoSoA. Only long runs let bulk
+// kernels such as Avx2Solution vectorize.
+template <class Solution>
+struct CountField
+{
+    static uint64_t Apply (const uint32_t* data, size_t size) noexcept
+    {
+        return CountBulk<Solution> (data, size);
+    }
+};
+
+template <class Solution>
+struct ReverseField
+{
+    static uint64_t Apply (const uint32_t* data, size_t size) noexcept
+    {
+        uint64_t res = 0;
+        for (size_t ii = 0; ii < size; ++ii)
+            res += static_cast<uint32_t> (Solution::reverse (static_cast<int> (data[ii])));
+        return res;
+    }
+};
+
+template <class Fill>
+void FillRandom (Fill&& fill)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
+    fill ([&gen, &dist]() { return dist(gen); });
+}
+
+template <size_t Fields>
+class Aos
+{
+public:
+    static constexpr size_t g_fields = Fields;
+
+    Aos()
+        : m_records (g_records)
+    {
+        FillRandom ([this](auto generator)
+            {
+                for (auto& record : m_records)
+                    for (auto& field : record.fields)
+                        field = generator();
+            });
+    }
+
+    // Lines are loaded whole, with every field of the record in them
+    static double LineUse (size_t touched) noexcept
+    {
+        return static_cast<double> (touched) / Fields;
+    }
+
+    template <class Op>
+    uint64_t Apply (size_t touched) const noexcept
+    {
+        uint64_t res = 0;
+        for (const auto& record : m_records)
+            res += Op::Apply (record.fields, touched);
+        return res;
+    }
+
+private:
+    struct Record
+    {
+        uint32_t fields[Fields];
+    };
+
+    std::vector<Record> m_records;
+};
+
+template <size_t Fields>
+class Soa
+{
+public:
+    static constexpr size_t g_fields = Fields;
+
+    Soa()
+    {
+        for (auto& column : m_columns)
+            column.resize (g_records);
+
+        FillRandom ([this](auto generator)
+            {
+                for (size_t record = 0; record < g_records; ++record)
+                    for (auto& column : m_columns)
+                        column[record] = generator();
+            });
+    }
+
+    static double LineUse (size_t) noexcept
+    {
+        return 1;
+    }
+
+    template <class Op>
+    uint64_t Apply (size_t touched) const noexcept
+    {
+        uint64_t res = 0;
+        for (size_t field = 0; field < touched; ++field)
+            res += Op::Apply (m_columns[field].data(), g_records);
+        return res;
+    }
+
+private:
+    std::array<std::vector<uint32_t>, Fields> m_columns;
+};
+
+template <size_t Fields>
+class AoSoA
+{
+public:
+    static constexpr size_t g_fields = Fields;
+
+    AoSoA()
+        : m_tiles (g_records / g_tile)
+    {
+        FillRandom ([this](auto generator)
+            {
+                for (auto& tile : m_tiles)
+                    for (size_t lane = 0; lane < g_tile; ++lane)
+                        for (auto& field : tile.fields)
+                            field[lane] = generator();
+            });
+    }
+
+    static double LineUse (size_t) noexcept
+    {
+        return 1;
+    }
+
+    template <class Op>
+    uint64_t Apply (size_t touched) const noexcept
+    {
+        uint64_t res = 0;
+        for (const auto& tile : m_tiles)
+            for (size_t field = 0; field < touched; ++field)
+                res += Op::Apply (tile.fields[field], g_tile);
+        return res;
+    }
+
+private:
+    struct alignas(64) Tile
+    {
+        uint32_t fields[Fields][g_tile];
+    };
+
+    std::vector<Tile> m_tiles;
+};
+
+}
+
+template <class Layout, class Op>
+void BM_Records (benchmark::State &state)
+{
+    const Layout layout;
+    const size_t touched = state.range (0);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        benchmark::DoNotOptimize (layout.template Apply<Op> (touched));
+    }
+
+    state.SetItemsProcessed (state.iterations() * g_records * touched);
+    state.counters["line_use"] = Layout::LineUse (touched);
+}
+
+template <class Layout>
+void TouchedFields (benchmark::internal::Benchmark* bench)
+{
+    bench->ArgName ("touched");
+    for (size_t touched = 1; touched <= Layout::g_fields; touched *= 4)
+        bench->Arg (touched);
+}
+
+#define RECORDS(Op, Fields) \
+    BENCHMARK_TEMPLATE(BM_Records, Aos<Fields>, Op)->Apply (TouchedFields<Aos<Fields>>); \
+    BENCHMARK_TEMPLATE(BM_Records, Soa<Fields>, Op)->Apply (TouchedFields<Soa<Fields>>); \
+    BENCHMARK_TEMPLATE(BM_Records, AoSoA<Fields>, Op)->Apply (TouchedFields<AoSoA<Fields>>);
+
+RECORDS(CountField<AsmSolution>, 4)
+RECORDS(CountField<AsmSolution>, 16)
+RECORDS(CountField<MagicSolution>, 4)
+RECORDS(CountField<MagicSolution>, 16)
+RECORDS(CountField<ByteTableSolution>, 16)
+RECORDS(CountField<Avx2Solution>, 4)
+RECORDS(CountField<Avx2Solution>, 16)
+RECORDS(ReverseField<reverse_int::MySolution>, 16)
+
+#undef RECORDS
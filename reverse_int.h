@@ -0,0 +1,85 @@
+#pragma once
+
+#include <limits.h>
+#include <stdint.h>
+
+namespace reverse_int
+{
+
+class MySolution
+{
+public:
+    static int reverse(int x)
+    {
+        if (x > 0)
+        {
+            const auto res = reverse(-x);
+            if (res == INT_MIN)
+                return 0;
+            return -res;
+        }
+
+        int res = 0;
+
+        while (x)
+        {
+            const int sub = x % 10;
+            x = x / 10;
+            if (res < INT_MIN / 10)
+                return 0;
+            if (res == INT_MIN / 10 && sub < -8)
+                return 0;
+            res = res * 10 + sub;
+        }
+
+        return res;
+    }
+};
+
+class ReferenceSolution
+{
+public:
+    static int reverse(int x)
+    {
+        int rev = 0;
+        while (x != 0)
+        {
+            int pop = x % 10;
+            x /= 10;
+            if (rev > INT_MAX / 10 || (rev == INT_MAX / 10 && pop > 7))
+                return 0;
+            if (rev < INT_MIN / 10 || (rev == INT_MIN / 10 && pop < -8))
+                return 0;
+            rev = rev * 10 + pop;
+        }
+        return rev;
+    }
+};
+
+// Same result as above in a fixed number of steps with no data-dependent branch: every
+// digit slot is visited and masked out once the input runs dry, sign and overflow are
+// applied as masks. Division by the constant 10 compiles to a multiply.
+class ConstantTimeSolution
+{
+public:
+    static int reverse(int x)
+    {
+        const uint64_t negative = static_cast<uint32_t>(x) >> 31;
+        const uint64_t negMask = 0 - negative;
+        uint64_t rest = (static_cast<uint64_t>(static_cast<int64_t>(x)) ^ negMask) - negMask;
+
+        uint64_t res = 0;
+        for (int ii = 0; ii < 10; ++ii)
+        {
+            const uint64_t live = 0 - ((rest | (0 - rest)) >> 63);
+            res = (res & ~live) | ((res * 10 + rest % 10) & live);
+            rest /= 10;
+        }
+
+        const uint64_t limit = static_cast<uint64_t>(INT_MAX) + negative;
+        const uint64_t fits = 0 - ((res - limit - 1) >> 63);
+        return static_cast<int>(static_cast<uint32_t>(((res ^ negMask) - negMask) & fits));
+    }
+};
+
+}
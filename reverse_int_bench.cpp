@@ -9,58 +9,17 @@
 
 #include <benchmark/benchmark.h>
 
-class MySolution
-{
-public:
-    static int reverse(int x)
-    {
-        if (x > 0)
-        {
-            const auto res = reverse(-x);
-            if (res == INT_MIN)
-                return 0;
-            return -res;
-        }
-
-        int res = 0;
-
-        while (x)
-        {
-            const int sub = x % 10;
-            x = x / 10;
-            if (res < INT_MIN / 10)
-                return 0;
-            if (res == INT_MIN / 10 && sub < -8)
-                return 0;
-            res = res * 10 + sub;
-        }
-
-        return res;
-    }
-};
+#include "kernel_stats.h"
+#include "rapl_counter.h"
+#include "reverse_int.h"
 
-class ReferenceSolution
-{
-public:
-    static int reverse(int x)
-    {
-        int rev = 0;
-        while (x != 0)
-        {
-            int pop = x % 10;
-            x /= 10;
-            if (rev > INT_MAX / 10 || (rev == INT_MAX / 10 && pop > 7))
-                return 0;
-            if (rev < INT_MIN / 10 || (rev == INT_MIN / 10 && pop < -8))
-                return 0;
-            rev = rev * 10 + pop;
-        }
-        return rev;
-    }
-};
+using reverse_int::ConstantTimeSolution;
+using reverse_int::MySolution;
+using reverse_int::ReferenceSolution;
 
+// Reverses batches of a random value until state is done
 template <class Solution>
-void BM_Find(benchmark::State &state)
+void FindLoop(benchmark::State &state)
 {
     std::mt19937 gen(42);
     std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
@@ -78,5 +37,32 @@ void BM_Find(benchmark::State &state)
     }
 }
 
+template <class Solution>
+void BM_Find(benchmark::State &state)
+{
+    FindLoop<Solution>(state);
+}
+
 BENCHMARK_TEMPLATE(BM_Find, ReferenceSolution);
-BENCHMARK_TEMPLATE(BM_Find, MySolution);
\ No newline at end of file
+BENCHMARK_TEMPLATE(BM_Find, MySolution);
+BENCHMARK_TEMPLATE(BM_Find, ConstantTimeSolution);
+BENCHMARK_TEMPLATE(BM_Find, kernel_stats::Instrumented<ReferenceSolution>);
+BENCHMARK_TEMPLATE(BM_Find, kernel_stats::Instrumented<MySolution>);
+
+template <class Solution>
+void BM_FindEnergy(benchmark::State &state)
+{
+    RaplCounter rapl;
+    if (!rapl.Available())
+    {
+        state.SkipWithError("powercap RAPL is unavailable");
+        return;
+    }
+
+    rapl.Start();
+    FindLoop<Solution>(state);
+    SetEnergyCounters(state, rapl);
+}
+
+BENCHMARK_TEMPLATE(BM_FindEnergy, ReferenceSolution);
+BENCHMARK_TEMPLATE(BM_FindEnergy, MySolution);
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+constexpr size_t g_cacheLine = 64;
+
+// Bounded single-producer single-consumer queue. Each side keeps a private copy of the
+// other side's index and only rereads the shared one when the copy says full / empty,
+// so the indices' cache lines bounce between cores once per lap rather than per element.
+template <class T>
+class SpscRing
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing (size_t capacity)
+        : m_mask (RoundUp (capacity) - 1),
+          m_slots (std::make_unique<T[]> (m_mask + 1))
+    {
+    }
+
+    bool TryPush (T value) noexcept
+    {
+        const auto head = m_producer.head.load (std::memory_order_relaxed);
+        if (head - m_producer.tailCache > m_mask)
+        {
+            m_producer.tailCache = m_consumer.tail.load (std::memory_order_acquire);
+            if (head - m_producer.tailCache > m_mask)
+                return false;
+        }
+
+        m_slots[head & m_mask] = std::move (value);
+        m_producer.head.store (head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop (T& value) noexcept
+    {
+        const auto tail = m_consumer.tail.load (std::memory_order_relaxed);
+        if (tail == m_consumer.headCache)
+        {
+            m_consumer.headCache = m_producer.head.load (std::memory_order_acquire);
+            if (tail == m_consumer.headCache)
+                return false;
+        }
+
+        value = std::move (m_slots[tail & m_mask]);
+        m_consumer.tail.store (tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+private:
+    static size_t RoundUp (size_t n) noexcept
+    {
+        size_t res = 1;
+        while (res < n)
+            res <<= 1;
+        return res;
+    }
+
+    struct alignas(g_cacheLine) Producer
+    {
+        std::atomic<size_t> head {0};
+        size_t tailCache = 0;
+    };
+
+    struct alignas(g_cacheLine) Consumer
+    {
+        std::atomic<size_t> tail {0};
+        size_t headCache = 0;
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+    Producer m_producer;
+    Consumer m_consumer;
+};
+
+// Bounded multi-producer multi-consumer queue after Dmitry Vyukov: every cell carries a
+// sequence number telling whether it is free for the lap a producer or consumer is on,
+// so both sides claim cells with a single CAS on their own index.
+template <class T>
+class MpmcRing
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit MpmcRing (size_t capacity)
+        : m_mask (RoundUp (capacity) - 1),
+          m_cells (std::make_unique<Cell[]> (m_mask + 1))
+    {
+        for (size_t ii = 0; ii <= m_mask; ++ii)
+            m_cells[ii].sequence.store (ii, std::memory_order_relaxed);
+    }
+
+    bool TryPush (T value) noexcept
+    {
+        auto head = m_head.value.load (std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = m_cells[head & m_mask];
+            const auto sequence = cell.sequence.load (std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t> (sequence) - static_cast<intptr_t> (head);
+            if (diff == 0)
+            {
+                if (m_head.value.compare_exchange_weak (head, head + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move (value);
+                    cell.sequence.store (head + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                head = m_head.value.load (std::memory_order_relaxed);
+        }
+    }
+
+    bool TryPop (T& value) noexcept
+    {
+        auto tail = m_tail.value.load (std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = m_cells[tail & m_mask];
+            const auto sequence = cell.sequence.load (std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t> (sequence) - static_cast<intptr_t> (tail + 1);
+            if (diff == 0)
+            {
+                if (m_tail.value.compare_exchange_weak (tail, tail + 1, std::memory_order_relaxed))
+                {
+                    value = std::move (cell.value);
+                    cell.sequence.store (tail + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                tail = m_tail.value.load (std::memory_order_relaxed);
+        }
+    }
+
+    size_t Capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+private:
+    static size_t RoundUp (size_t n) noexcept
+    {
+        size_t res = 1;
+        while (res < n)
+            res <<= 1;
+        return res;
+    }
+
+    struct alignas(g_cacheLine) Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    struct alignas(g_cacheLine) Index
+    {
+        std::atomic<size_t> value {0};
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    Index m_head;
+    Index m_tail;
+};
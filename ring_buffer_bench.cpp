@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "count_bits.h"
+#include "reverse_int.h"
+#include "ring_buffer.h"
+
+// Producers fill batches of uint32_t and hand them through a lock-free ring to consumers
+// that apply a Count or reverse solution. Reports elements/s end to end and the average
+// time a batch waits between push and pop.
+
+namespace
+{
+
+constexpr size_t g_elementsPerIteration = 1 << 20;
+constexpr size_t g_ringCapacity = 64;
+
+template <class Solution>
+struct CountOp
+{
+    static uint64_t Apply (const uint32_t* data, size_t size) noexcept
+    {
+        return CountBulk<Solution> (data, size);
+    }
+};
+
+template <class Solution>
+struct ReverseOp
+{
+    static uint64_t Apply (const uint32_t* data, size_t size) noexcept
+    {
+        uint64_t res = 0;
+        for (size_t ii = 0; ii < size; ++ii)
+            res += Solution::reverse (static_cast<int> (data[ii]));
+        return res;
+    }
+};
+
+struct Batch
+{
+    const uint32_t* data;
+    uint32_t size;
+    uint32_t producer;
+    uint32_t slot;
+    int64_t pushedNs;
+};
+
+int64_t NowNs() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct alignas(g_cacheLine) ConsumerStats
+{
+    uint64_t batches = 0;
+    uint64_t waitNs = 0;
+    uint64_t sink = 0;
+};
+
+// Producer and consumer threads live as long as the pipeline; every Run() is one iteration in
+// which each producer pushes its share of batches and the consumers drain until all arrived.
+// A producer only fills arena slots from its free ring, which consumers return them to once
+// applied, so a batch is never rewritten while some consumer still reads it.
+template <class Op, class Ring>
+class Pipeline
+{
+public:
+    Pipeline (size_t producers, size_t consumers, size_t batch)
+        : m_ring (g_ringCapacity),
+          m_batch (batch),
+          m_batchesPerProducer (g_elementsPerIteration / batch / producers),
+          m_stats (consumers)
+    {
+        // Enough slots for a full ring plus one batch in the hands of every consumer
+        const size_t slots = m_ring.Capacity() + consumers;
+        for (size_t producer = 0; producer < producers; ++producer)
+        {
+            m_arenas.emplace_back (slots * batch);
+            m_free.push_back (std::make_unique<MpmcRing<uint32_t>> (slots));
+            for (size_t slot = 0; slot < slots; ++slot)
+                m_free.back()->TryPush (static_cast<uint32_t> (slot));
+        }
+
+        for (size_t producer = 0; producer < producers; ++producer)
+            m_threads.emplace_back ([this, producer]() { Serve ([this, producer]() { Produce (producer); }); });
+        for (size_t consumer = 0; consumer < consumers; ++consumer)
+            m_threads.emplace_back ([this, consumer]() { Serve ([this, consumer]() { Consume (consumer); }); });
+    }
+
+    Pipeline (const Pipeline&) = delete;
+    Pipeline& operator= (const Pipeline&) = delete;
+
+    ~Pipeline()
+    {
+        m_stop.store (true, std::memory_order_relaxed);
+        m_generation.fetch_add (1, std::memory_order_release);
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    void Run() noexcept
+    {
+        m_remaining.store (m_batchesPerProducer * m_arenas.size(), std::memory_order_relaxed);
+        m_done.store (0, std::memory_order_relaxed);
+        m_generation.fetch_add (1, std::memory_order_release);
+        while (m_done.load (std::memory_order_acquire) != m_threads.size())
+            std::this_thread::yield();
+    }
+
+    const std::vector<ConsumerStats>& Stats() const noexcept
+    {
+        return m_stats;
+    }
+
+private:
+    // Runs work once per generation until the pipeline stops
+    template <class Work>
+    void Serve (Work work)
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            uint64_t generation;
+            while ((generation = m_generation.load (std::memory_order_acquire)) == seen)
+                std::this_thread::yield();
+            seen = generation;
+
+            if (m_stop.load (std::memory_order_relaxed))
+                return;
+
+            work();
+            m_done.fetch_add (1, std::memory_order_release);
+        }
+    }
+
+    void Produce (size_t producer)
+    {
+        auto& free = *m_free[producer];
+        uint32_t state = 0x9E3779B9u * static_cast<uint32_t> (producer + 1);
+
+        for (size_t ii = 0; ii < m_batchesPerProducer; ++ii)
+        {
+            uint32_t slot;
+            while (!free.TryPop (slot))
+                std::this_thread::yield();
+
+            auto* data = m_arenas[producer].data() + slot * m_batch;
+            for (size_t jj = 0; jj < m_batch; ++jj)
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                data[jj] = state;
+            }
+
+            const Batch item {data, static_cast<uint32_t> (m_batch), static_cast<uint32_t> (producer), slot, NowNs()};
+            while (!m_ring.TryPush (item))
+                std::this_thread::yield();
+        }
+    }
+
+    void Consume (size_t consumer)
+    {
+        auto& stats = m_stats[consumer];
+        Batch item;
+        while (m_remaining.load (std::memory_order_relaxed))
+        {
+            if (!m_ring.TryPop (item))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            stats.waitNs += NowNs() - item.pushedNs;
+            stats.sink += Op::Apply (item.data, item.size);
+            ++stats.batches;
+
+            // The free ring holds every slot of its producer, so this never fails
+            m_free[item.producer]->TryPush (item.slot);
+            m_remaining.fetch_sub (1, std::memory_order_relaxed);
+        }
+    }
+
+    Ring m_ring;
+    const size_t m_batch;
+    const size_t m_batchesPerProducer;
+    std::vector<std::vector<uint32_t>> m_arenas;
+    std::vector<std::unique_ptr<MpmcRing<uint32_t>>> m_free;
+    std::vector<ConsumerStats> m_stats;
+
+    std::atomic<uint64_t> m_generation {0};
+    std::atomic<size_t> m_remaining {0};
+    std::atomic<size_t> m_done {0};
+    std::atomic<bool> m_stop {false};
+    std::vector<std::thread> m_threads;
+};
+
+template <class Op, class Ring>
+void RunRing (benchmark::State &state, size_t producers, size_t consumers)
+{
+    const size_t batch = state.range (0);
+    Pipeline<Op, Ring> pipeline (producers, consumers, batch);
+
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        pipeline.Run();
+    }
+
+    uint64_t batches = 0, waitNs = 0, sink = 0;
+    for (const auto& consumer : pipeline.Stats())
+    {
+        batches += consumer.batches;
+        waitNs += consumer.waitNs;
+        sink += consumer.sink;
+    }
+    benchmark::DoNotOptimize (sink);
+
+    state.SetItemsProcessed (batches * batch);
+    state.counters["handoff_ns"] = batches ? static_cast<double> (waitNs) / batches : 0;
+}
+
+}
+
+template <class Op>
+void BM_RingSpsc (benchmark::State &state)
+{
+    RunRing<Op, SpscRing<Batch>> (state, 1, 1);
+}
+
+// Args: batch size, producer threads, consumer threads
+template <class Op>
+void BM_RingMpmc (benchmark::State &state)
+{
+    RunRing<Op, MpmcRing<Batch>> (state, state.range (1), state.range (2));
+}
+
+BENCHMARK_TEMPLATE(BM_RingSpsc, CountOp<AsmSolution>)->UseRealTime()->RangeMultiplier (16)->Range (16, 4096);
+BENCHMARK_TEMPLATE(BM_RingSpsc, CountOp<ByteTableSolution>)->UseRealTime()->RangeMultiplier (16)->Range (16, 4096);
+BENCHMARK_TEMPLATE(BM_RingSpsc, ReverseOp<reverse_int::MySolution>)->UseRealTime()->RangeMultiplier (16)->Range (16, 4096);
+
+BENCHMARK_TEMPLATE(BM_RingMpmc, CountOp<AsmSolution>)->UseRealTime()->ArgsProduct ({{16, 256, 4096}, {1, 2, 4}, {1, 2, 4}});
+BENCHMARK_TEMPLATE(BM_RingMpmc, CountOp<ByteTableSolution>)->UseRealTime()->ArgsProduct ({{16, 256, 4096}, {1, 2, 4}, {1, 2, 4}});
+BENCHMARK_TEMPLATE(BM_RingMpmc, ReverseOp<reverse_int::MySolution>)->UseRealTime()->ArgsProduct ({{16, 256, 4096}, {1, 2, 4}, {1, 2, 4}});
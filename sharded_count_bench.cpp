@@ -0,0 +1,196 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "count_bits.h"
+#include "ring_buffer.h"
+
+// Popcount of one huge bitmap split into shards: forked worker processes over a POSIX
+// shared-memory segment against threads of this process over the very same memory.
+// Every worker reports through its own cache line of a shared result array.
+
+namespace
+{
+
+constexpr size_t g_words = 1 << 26; // 256 MiB
+constexpr size_t g_maxWorkers = 64;
+
+struct alignas(g_cacheLine) ShardResult
+{
+    uint64_t value;
+};
+
+struct Layout
+{
+    ShardResult results[g_maxWorkers];
+    alignas(4096) uint32_t words[g_words];
+};
+
+// Created and filled once per process, unlinked right away so nothing leaks if we crash
+class SharedBitmap
+{
+public:
+    static SharedBitmap& Instance()
+    {
+        static SharedBitmap bitmap;
+        return bitmap;
+    }
+
+    Layout* Get() const noexcept
+    {
+        return m_layout;
+    }
+
+    uint64_t Expected() const noexcept
+    {
+        return m_expected;
+    }
+
+private:
+    SharedBitmap()
+    {
+        const auto name = "/sharded_count." + std::to_string (getpid());
+        const int fd = shm_open (name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            return;
+        shm_unlink (name.c_str());
+
+        void* memory = MAP_FAILED;
+        if (ftruncate (fd, sizeof (Layout)) == 0)
+            memory = mmap (nullptr, sizeof (Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close (fd);
+        if (memory == MAP_FAILED)
+            return;
+
+        m_layout = static_cast<Layout*> (memory);
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<uint32_t>::max());
+        for (auto& word : m_layout->words)
+            word = dist(gen);
+        m_expected = CountBulk<AsmSolution> (m_layout->words, g_words);
+    }
+
+    ~SharedBitmap()
+    {
+        if (m_layout)
+            munmap (m_layout, sizeof (Layout));
+    }
+
+    Layout* m_layout = nullptr;
+    uint64_t m_expected = 0;
+};
+
+template <class Solution>
+void CountShard (Layout& layout, size_t worker, size_t workers)
+{
+    const auto begin = g_words * worker / workers;
+    const auto end = g_words * (worker + 1) / workers;
+    layout.results[worker].value = CountBulk<Solution> (layout.words + begin, end - begin);
+}
+
+uint64_t Reduce (const Layout& layout, size_t workers)
+{
+    uint64_t res = 0;
+    for (size_t worker = 0; worker < workers; ++worker)
+        res += layout.results[worker].value;
+    return res;
+}
+
+}
+
+// Args: worker processes, forked anew for every pass
+template <class Solution>
+void BM_ShardedProcesses (benchmark::State &state)
+{
+    auto* layout = SharedBitmap::Instance().Get();
+    if (!layout)
+    {
+        state.SkipWithError ("POSIX shared memory is unavailable");
+        return;
+    }
+
+    const size_t workers = state.range (0);
+    Solution::Count (42); // Heatup table before fork, so children share it
+
+    std::vector<pid_t> children (workers);
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t worker = 0; worker < workers; ++worker)
+        {
+            children[worker] = fork();
+            if (children[worker] == 0)
+            {
+                CountShard<Solution> (*layout, worker, workers);
+                _exit (0);
+            }
+        }
+
+        bool failed = false;
+        for (const auto child : children)
+        {
+            int status = 0;
+            failed |= child < 0 || waitpid (child, &status, 0) != child || !WIFEXITED (status) || WEXITSTATUS (status);
+        }
+
+        if (failed || Reduce (*layout, workers) != SharedBitmap::Instance().Expected())
+        {
+            state.SkipWithError ("worker failed");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed (state.iterations() * g_words * sizeof (uint32_t));
+}
+
+// Args: worker threads, started anew for every pass
+template <class Solution>
+void BM_ShardedThreads (benchmark::State &state)
+{
+    auto* layout = SharedBitmap::Instance().Get();
+    if (!layout)
+    {
+        state.SkipWithError ("POSIX shared memory is unavailable");
+        return;
+    }
+
+    const size_t workers = state.range (0);
+    Solution::Count (42); // Heatup table
+
+    std::vector<std::thread> threads;
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t worker = 0; worker < workers; ++worker)
+            threads.emplace_back ([layout, worker, workers]() { CountShard<Solution> (*layout, worker, workers); });
+        for (auto& thread : threads)
+            thread.join();
+        threads.clear();
+
+        if (Reduce (*layout, workers) != SharedBitmap::Instance().Expected())
+        {
+            state.SkipWithError ("wrong count");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed (state.iterations() * g_words * sizeof (uint32_t));
+}
+
+BENCHMARK_TEMPLATE(BM_ShardedProcesses, AsmSolution)->UseRealTime()->RangeMultiplier (2)->Range (1, 16);
+BENCHMARK_TEMPLATE(BM_ShardedThreads, AsmSolution)->UseRealTime()->RangeMultiplier (2)->Range (1, 16);
+BENCHMARK_TEMPLATE(BM_ShardedProcesses, WordsTableSolution)->UseRealTime()->RangeMultiplier (2)->Range (1, 16);
+BENCHMARK_TEMPLATE(BM_ShardedThreads, WordsTableSolution)->UseRealTime()->RangeMultiplier (2)->Range (1, 16);
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "count_bits.h"
+
+// Set bits among the last W bits of many bit streams advancing in lockstep, one 32-bit word
+// per stream per step. With W = 32 q + r the bits leaving the window on a step are the top r
+// bits of word n - q - 1 and the low 32 - r bits of word n - q, one funnel shift of the two,
+// so a step is popcount(in) - popcount(out) per stream instead of a recount of the window.
+
+namespace sliding_window
+{
+
+// Kernels advance every stream by one word: counts += popcount(in) - popcount(out) with out
+// the funnel of older:newer shifted right by 32 - rest, and the incoming words go to slot
+
+template <class Solution>
+struct ScalarKernel
+{
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    static void Step (const uint32_t* in, const uint32_t* newer, const uint32_t* older, uint32_t* slot,
+        uint32_t* counts, size_t streams, unsigned rest) noexcept
+    {
+        for (size_t ss = 0; ss < streams; ++ss)
+        {
+            const auto out = static_cast<uint32_t> (((uint64_t (newer[ss]) << 32) | older[ss]) >> (32 - rest));
+            counts[ss] += Solution::Count (in[ss]) - Solution::Count (out);
+            slot[ss] = in[ss];
+        }
+    }
+};
+
+// 16 streams per vpopcntd; shifts by 32 give zero, which is the r = 0 case
+struct Avx512Kernel
+{
+    static bool Available() noexcept
+    {
+        return __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512vpopcntdq");
+    }
+
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static void Step (const uint32_t* in, const uint32_t* newer, const uint32_t* older, uint32_t* slot,
+        uint32_t* counts, size_t streams, unsigned rest) noexcept
+    {
+        const auto left = _mm_cvtsi32_si128 (rest);
+        const auto right = _mm_cvtsi32_si128 (32 - rest);
+        for (size_t ss = 0; ss < streams; ss += 16)
+        {
+            const auto mask = static_cast<__mmask16> (streams - ss >= 16 ? 0xFFFF : (1u << (streams - ss)) - 1);
+            const auto v = _mm512_maskz_loadu_epi32 (mask, in + ss);
+            const auto out = _mm512_or_si512 (_mm512_sll_epi32 (_mm512_maskz_loadu_epi32 (mask, newer + ss), left),
+                _mm512_srl_epi32 (_mm512_maskz_loadu_epi32 (mask, older + ss), right));
+            const auto delta = _mm512_sub_epi32 (_mm512_popcnt_epi32 (v), _mm512_popcnt_epi32 (out));
+            _mm512_mask_storeu_epi32 (counts + ss, mask, _mm512_add_epi32 (_mm512_maskz_loadu_epi32 (mask, counts + ss), delta));
+            _mm512_mask_storeu_epi32 (slot + ss, mask, v);
+        }
+    }
+};
+
+// Incremental windows. The history is a ring of whole steps, slot-major so that a step reads
+// and writes contiguous words; it holds q + 2 steps rounded up to a power of two, and slots
+// not written yet are zero, the bits before the stream started.
+template <class Kernel>
+class Windows
+{
+public:
+    Windows (size_t streams, size_t windowBits)
+        : m_streams (streams),
+          m_full (windowBits / 32),
+          m_rest (windowBits % 32),
+          m_mask (RoundUp (m_full + 2) - 1),
+          m_ring ((m_mask + 1) * streams),
+          m_counts (streams)
+    {
+    }
+
+    static bool Available() noexcept
+    {
+        return Kernel::Available();
+    }
+
+    // One word for every stream
+    void Push (const uint32_t* words) noexcept
+    {
+        // Under a word of window the newer half of the funnel is the incoming word itself
+        const auto* newer = m_full ? Slot ((m_position - m_full) & m_mask) : words;
+        const auto* older = Slot ((m_position - m_full - 1) & m_mask);
+        Kernel::Step (words, newer, older, Slot (m_position & m_mask), m_counts.data(), m_streams, m_rest);
+        ++m_position;
+    }
+
+    const uint32_t* Counts() const noexcept
+    {
+        return m_counts.data();
+    }
+
+private:
+    static size_t RoundUp (size_t n) noexcept
+    {
+        size_t res = 1;
+        while (res < n)
+            res <<= 1;
+        return res;
+    }
+
+    uint32_t* Slot (size_t index) noexcept
+    {
+        return m_ring.data() + index * m_streams;
+    }
+
+    size_t m_streams;
+    size_t m_full;
+    unsigned m_rest;
+    size_t m_mask;
+    size_t m_position = 0;
+    std::vector<uint32_t> m_ring;
+    std::vector<uint32_t> m_counts;
+};
+
+// The baseline: every step recounts each window with CountBulk. Every stream keeps its last
+// q + 1 words twice over, so the window always is one contiguous span ending at the newest.
+template <class Solution>
+class RecomputeWindows
+{
+public:
+    RecomputeWindows (size_t streams, size_t windowBits)
+        : m_streams (streams),
+          m_full (windowBits / 32),
+          m_rest (windowBits % 32),
+          m_length (m_full + 1),
+          m_history (streams * 2 * m_length),
+          m_counts (streams)
+    {
+    }
+
+    static bool Available() noexcept
+    {
+        return true;
+    }
+
+    void Push (const uint32_t* words) noexcept
+    {
+        for (size_t ss = 0; ss < m_streams; ++ss)
+        {
+            auto* history = m_history.data() + ss * 2 * m_length;
+            history[m_position] = history[m_position + m_length] = words[ss];
+
+            const auto* newest = history + m_position + m_length;
+            auto count = CountBulk<Solution> (newest + 1 - m_full, m_full);
+            if (m_rest)
+            {
+                const uint32_t partial = newest[-static_cast<ptrdiff_t> (m_full)] >> (32 - m_rest);
+                count += CountBulk<Solution> (&partial, 1);
+            }
+            m_counts[ss] = static_cast<uint32_t> (count);
+        }
+
+        if (++m_position == m_length)
+            m_position = 0;
+    }
+
+    const uint32_t* Counts() const noexcept
+    {
+        return m_counts.data();
+    }
+
+private:
+    size_t m_streams;
+    size_t m_full;
+    unsigned m_rest;
+    size_t m_length;
+    size_t m_position = 0;
+    std::vector<uint32_t> m_history;
+    std::vector<uint32_t> m_counts;
+};
+
+}
@@ -0,0 +1,120 @@
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/ignore_unused.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "best_count.h"
+#include "sliding_window.h"
+
+using sliding_window::Avx512Kernel;
+using sliding_window::RecomputeWindows;
+using sliding_window::ScalarKernel;
+using sliding_window::Windows;
+
+namespace
+{
+
+// Steps are cycled through, enough of them to keep the input out of L1
+constexpr size_t g_steps = 64;
+
+std::vector<uint32_t> RandomWords (size_t size, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::vector<uint32_t> res (size);
+    for (auto& word : res)
+        word = gen();
+    return res;
+}
+
+}
+
+// Args: streams, window bits. One item is one stream advanced by one word.
+template <class Engine>
+void BM_SlidingWindow (benchmark::State &state)
+{
+    if (!Engine::Available())
+    {
+        state.SkipWithError ("kernel not supported by this cpu");
+        return;
+    }
+
+    const size_t streams = state.range (0);
+    const auto words = RandomWords (g_steps * streams, 1);
+    Engine windows (streams, state.range (1));
+
+    size_t step = 0;
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        windows.Push (words.data() + step * streams);
+        step = (step + 1) % g_steps;
+        benchmark::DoNotOptimize (windows.Counts());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * streams);
+}
+
+static void WindowArgs (benchmark::internal::Benchmark* b)
+{
+    b->ArgNames ({"streams", "window"});
+    for (int64_t streams : {64, 4096})
+        for (int64_t window : {100, 1000, 10000})
+            b->Args ({streams, window});
+}
+
+BENCHMARK_TEMPLATE(BM_SlidingWindow, Windows<ScalarKernel<AsmSolution>>)->Apply (WindowArgs);
+BENCHMARK_TEMPLATE(BM_SlidingWindow, Windows<ScalarKernel<MagicSolution>>)->Apply (WindowArgs);
+BENCHMARK_TEMPLATE(BM_SlidingWindow, Windows<Avx512Kernel>)->Apply (WindowArgs);
+BENCHMARK_TEMPLATE(BM_SlidingWindow, RecomputeWindows<AsmSolution>)->Apply (WindowArgs);
+BENCHMARK_TEMPLATE(BM_SlidingWindow, RecomputeWindows<Avx2Solution>)->Apply (WindowArgs);
+BENCHMARK_TEMPLATE(BM_SlidingWindow, RecomputeWindows<BestCount>)->Apply (WindowArgs);
+
+// Every engine against a bit-by-bit count of the last W bits after every step, on windows
+// around word boundaries and stream counts leaving vector tails
+void BM_SlidingWindowCheck (benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        boost::ignore_unused (_);
+        for (size_t window : {1, 31, 32, 33, 64, 100, 1000})
+            for (size_t streams : {1, 17, 33})
+            {
+                const size_t steps = 3 * window / 32 + 50;
+                const auto words = RandomWords (steps * streams, static_cast<uint32_t> (window + streams));
+
+                Windows<ScalarKernel<AsmSolution>> scalar (streams, window);
+                Windows<Avx512Kernel> avx512 (streams, window);
+                RecomputeWindows<AsmSolution> recompute (streams, window);
+                RecomputeWindows<BestCount> recomputeBest (streams, window);
+
+                for (size_t step = 0; step < steps; ++step)
+                {
+                    const auto* batch = words.data() + step * streams;
+                    scalar.Push (batch);
+                    recompute.Push (batch);
+                    recomputeBest.Push (batch);
+                    if (Avx512Kernel::Available())
+                        avx512.Push (batch);
+
+                    const auto bits = (step + 1) * 32;
+                    for (size_t ss = 0; ss < streams; ++ss)
+                    {
+                        uint32_t etalon = 0;
+                        for (size_t bit = bits - std::min (bits, window); bit < bits; ++bit)
+                            etalon += (words[bit / 32 * streams + ss] >> (bit % 32)) & 1;
+
+                        if (scalar.Counts()[ss] != etalon || recompute.Counts()[ss] != etalon ||
+                            recomputeBest.Counts()[ss] != etalon ||
+                            (Avx512Kernel::Available() && avx512.Counts()[ss] != etalon))
+                            throw std::runtime_error ("test");
+                    }
+                }
+            }
+    }
+}
+
+BENCHMARK (BM_SlidingWindowCheck);